@@ -1,13 +1,22 @@
 #pragma once
 
 #include <qt_qa_engine/IEnginePlatform.h>
+#include <qt_qa_engine/QAPendingEvent.h>
+
+#include <QMetaProperty>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
 
 class QAKeyMouseEngine;
+class QAReplyStream;
 class QTouchEvent;
 class QMouseEvent;
 class QKeyEvent;
 class QWindow;
 class QXmlStreamWriter;
+class QIODevice;
 
 class AnalyzeEventFilter : public QObject
 {
@@ -23,6 +32,30 @@ protected:
     bool eventFilter(QObject* watched, QEvent* event) override;
 };
 
+class PropertyChangeWaiter : public QAPendingEvent
+{
+    Q_OBJECT
+
+public:
+    explicit PropertyChangeWaiter(QObject* item,
+                                  const QMetaProperty& property,
+                                  const QVariant& value,
+                                  int timeout,
+                                  QObject* parent = nullptr);
+
+private slots:
+    void onPropertyChanged();
+    void onTimeout();
+
+private:
+    void finish(bool result);
+
+    QPointer<QObject> m_item;
+    QMetaProperty m_property;
+    QVariant m_value;
+    QTimer m_timer;
+};
+
 class GenericEnginePlatform : public IEnginePlatform
 {
     Q_OBJECT
@@ -32,6 +65,11 @@ public:
     QObject* rootObject() override;
 
     void socketReply(ITransportClient* socket, const QVariant& value, int status = 0) override;
+    void deferredReply(ITransportClient* socket,
+                       const QVariant& requestId,
+                       const QVariant& value,
+                       int status = 0);
+    void pendingReply(ITransportClient* socket, QAPendingEvent* pending);
     void elementReply(ITransportClient* socket,
                       QObjectList elements,
                       bool multiple = false) override;
@@ -54,7 +92,9 @@ public:
     virtual QString getObjectId(QObject *item) override;
 
     void startAnalyze(ITransportClient* client) override;
-    void stopAnalyze() override;
+    void stopAnalyze(ITransportClient* client) override;
+
+    void sessionClosed(QASession* session) override;
 
 protected:
     friend class QAKeyMouseEngine;
@@ -98,7 +138,19 @@ protected:
 
     QJsonObject dumpObject(QObject* item, const QVariantList &filters, int depth = 0);
     QJsonObject recursiveDumpTree(QObject* rootItem, const QVariantList &filters, int depth = 0);
+    // writes object as JSON text with its children array left open, false if filtered out
+    bool writeTreeNode(QIODevice* device,
+                       QObject* item,
+                       const QVariantList& filters,
+                       int depth,
+                       bool separator);
+    // write the same documents as recursiveDumpTree() and recursiveDumpXml() node by node,
+    // the stream pauses the walk while the client is backpressured
+    void streamDumpTree(QAReplyStream* stream, const QVariantList& filters);
+    void streamDumpXml(QAReplyStream* stream);
     bool recursiveDumpXml(QXmlStreamWriter* writer, QObject* rootItem, int depth = 0);
+    // start tag with attributes and text, children and end tag are up to the caller
+    void writeXmlElement(QXmlStreamWriter* writer, QObject* rootItem, int depth);
 
     virtual QByteArray grabDirectScreenshot() = 0;
 
@@ -106,38 +158,44 @@ protected:
                                 QObject* item,
                                 bool fillBackground = false) = 0;
     void waitForClick(ITransportClient* socket, QObject*);
-    void clickItem(QObject* item);
-
-    void clickPoint(float posx, float posy);
-    void clickPoint(const QPoint& pos);
-    virtual void pressAndHoldItem(QObject* item, int delay = 800) = 0;
-    void pressAndHold(float posx, float posy, int delay = 800);
-    void mouseMove(float startx, float starty, float stopx, float stopy);
-    void mouseDrag(float startx, float starty, float stopx, float stopy, int delay = 1200);
-    void processTouchActionList(const QVariant& actionListArg);
-    bool waitForPropertyChange(QObject* item,
-                               const QString& propertyName,
-                               const QVariant& value,
-                               int timeout = 10000);
-    bool waitForWindowChange(int timeout = 10000);
+    // gestures complete asynchronously, reply with pendingReply instead of waiting
+    QAPendingEvent* clickItem(QObject* item);
+
+    QAPendingEvent* clickPoint(float posx, float posy);
+    QAPendingEvent* clickPoint(const QPoint& pos);
+    virtual QAPendingEvent* pressAndHoldItem(QObject* item, int delay = 800) = 0;
+    QAPendingEvent* pressAndHold(float posx, float posy, int delay = 800);
+    QAPendingEvent* mouseMove(float startx, float starty, float stopx, float stopy);
+    QAPendingEvent* mouseDrag(float startx, float starty, float stopx, float stopy, int delay = 1200);
+    QAPendingEvent* processTouchActionList(const QVariant& actionListArg);
+    QAPendingEvent* completedEvent(const QVariant& result);
+    // completes msecs after event, so the app can handle what the gesture triggered
+    QAPendingEvent* settledEvent(QAPendingEvent* event, int msecs);
+    QAPendingEvent* delayedEvent(int msecs);
+    // runs steps one after another, each step starts when the previous one completes
+    QAPendingEvent* sequenceEvent(const QList<std::function<QAPendingEvent*()>>& steps);
+    QAPendingEvent* waitForPropertyChange(QObject* item,
+                                          const QString& propertyName,
+                                          const QVariant& value,
+                                          int timeout = 10000);
+    QAPendingEvent* waitForWindowChange(int timeout = 10000);
     bool registerSignal(QObject* item,
                         const QString& signalName);
     bool unregisterSignal(QObject* item,
                         const QString& signalName);
+    bool isSignalRegistered(const QString& key);
 
     bool checkMatch(const QString& pattern, const QString& value);
 
     QWindow* m_rootWindow = nullptr;
     QObject* m_rootObject = nullptr;
 
-    QHash<QString, QObject*> m_items;
     QAKeyMouseEngine* m_keyMouseEngine = nullptr;
 
     QHash<QString, QStringList> m_blacklistedProperties;
-    QHash<QString, int> m_signalCounter;
 
-    QVariantList m_lastFilters;
-    ITransportClient* m_analyzeSocket = nullptr;
+    // element handles, filters and signal counters live in QASession of each client
+    QList<ITransportClient*> m_analyzeClients;
     AnalyzeEventFilter* m_analyzeEventFilter = nullptr;
 
 public slots:
@@ -150,10 +208,13 @@ signals:
 
 private:
     void execute(ITransportClient* socket, const QString& methodName, const QVariantList& params);
+    // false if command is not registered with QAEngine::registerCommand
+    bool executeRegistered(ITransportClient* socket,
+                           const QString& command,
+                           const QVariantList& params);
 
 private slots:
     // own stuff
-    void onPropertyChanged();
     void onSignalReceived();
 
     void analyzePressed(const QPoint &point);
@@ -340,6 +401,11 @@ private slots:
                                               const QString& elementId,
                                               const QString& signalName);
     void executeCommand_app_setLoggingFilter(ITransportClient* socket, const QString& rules);
+    void executeCommand_app_stats(ITransportClient* socket);
+    void executeCommand_app_resetStats(ITransportClient* socket);
+    void executeCommand_app_startTrace(ITransportClient* socket);
+    void executeCommand_app_stopTrace(ITransportClient* socket);
+    void executeCommand_app_stopTrace(ITransportClient* socket, const QString& filePath);
     void executeCommand_app_installFileLogger(ITransportClient* socket, const QString& filePath);
     void executeCommand_app_click(ITransportClient* socket, double mousex, double mousey);
     void executeCommand_app_click(ITransportClient* socket, qlonglong mousex, qlonglong mousey);
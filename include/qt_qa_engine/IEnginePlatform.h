@@ -7,6 +7,7 @@
 #include <QWindow>
 
 class ITransportClient;
+class QASession;
 class IEnginePlatform : public QObject
 {
     Q_OBJECT
@@ -41,7 +42,10 @@ public:
     virtual QString getObjectId(QObject *item) = 0;
 
     virtual void startAnalyze(ITransportClient* client) = 0;
-    virtual void stopAnalyze() = 0;
+    virtual void stopAnalyze(ITransportClient* client) = 0;
+
+    // client is gone, release everything platform keeps for its session
+    virtual void sessionClosed(QASession* session) = 0;
 
 public slots:
     virtual void initialize() = 0;
@@ -1,29 +1,160 @@
 #pragma once
 
+#include <qt_qa_engine/QAFrameDecoder.h>
+
+#include <QAtomicInteger>
 #include <QByteArray>
+#include <QList>
 #include <QObject>
+#include <QScopedPointer>
+#include <QVariantList>
+#include <QVariantMap>
 
+class QACompressor;
+class QASharedMemoryChannel;
 class ITransportClient : public QObject
 {
     Q_OBJECT
 public:
+    enum Encoding
+    {
+        JsonEncoding,
+        CborEncoding,
+    };
+
     explicit ITransportClient(QObject* parent = nullptr);
+    ~ITransportClient() override;
 
     virtual qint64 bytesAvailable() = 0;
     virtual QByteArray readAll() = 0;
 
     virtual bool isOpen() = 0;
     virtual bool isConnected() = 0;
-    virtual void close() = 0;
+    Q_INVOKABLE virtual void close() = 0;
 
     virtual qint64 write(const QByteArray& data) = 0;
     virtual bool flush() = 0;
+    virtual qint64 bytesToWrite() = 0;
 
     virtual bool waitForBytesWritten(int msecs = 30000) = 0;
     virtual bool waitForReadyRead(int msecs = 30000) = 0;
 
+    QAFrameDecoder* decoder();
+    QAFrameDecoder::Mode framingMode() const;
+    void setFramingMode(QAFrameDecoder::Mode mode);
+
+    qint64 writeFrame(const QByteArray& data);
+
+    // thread safe, encoding and writing happen on the thread owning the client
+    void sendReply(const QVariant& requestId, const QVariant& value, int status = 0);
+    // tagged data replaces not yet written data with the same tag
+    void post(const QByteArray& data, const QString& tag = QString());
+    // same as post(), framed and compressed as negotiated on the thread owning the client
+    void postFrame(const QByteArray& data, const QString& tag = QString());
+    // part of a reply written while it is produced, thread safe. Data posted by others after
+    // the first part is held back until the last part, so it does not land inside the reply
+    void postStreamChunk(const QByteArray& data, bool last);
+
+    // output queue, thread safe, posted data counts as pending as soon as post() returns
+    static const qint64 s_defaultHighWaterMark = 16 * 1024 * 1024;
+    static const qint64 s_defaultLowWaterMark = 4 * 1024 * 1024;
+
+    qint64 pendingBytes() const;
+    bool isBackpressured() const;
+    void setWaterMarks(qint64 low, qint64 high);
+
+    // reply value for a binary payload: shared memory handle if negotiated,
+    // raw bytes for CBOR encoding, base64 otherwise
+    virtual QVariant payloadValue(const QByteArray& payload);
+
+    // client whose session commands run in, differs for clients nested into another one
+    virtual ITransportClient* sessionClient();
+
+    QVariant requestId() const;
+    // id the session tracks pending events of the current request under, so cancel by id
+    // reaches them, nested clients keep ids of their own requests apart from client ids
+    virtual QVariant sessionRequestId() const;
+    void beginRequest(const QVariant& requestId);
+    void endRequest();
+
+    QVariantMap negotiate(const QVariantMap& requested);
+    Q_INVOKABLE void applyNegotiated();
+    QVariantMap connectionOptions() const;
+    // back to defaults for a reused client reconnecting to its peer, client thread only,
+    // covers framing, encoding and output queue
+    void resetConnection();
+    // negotiated options, shared memory and request ids back to defaults, GUI thread only,
+    // called when the client is lost, so it happens before commands of the next connection
+    void resetNegotiation();
+    // large replies may be written with QAReplyStream, thread safe
+    bool isStreaming() const;
+
 signals:
     void readyRead(ITransportClient* client);
     void connected(ITransportClient* client);
     void disconnected(ITransportClient* client);
+    void bytesWritten(ITransportClient* client, qint64 bytes);
+
+    // emitted when pending bytes cross water marks, on the thread which posted or wrote data
+    void highWaterMarkReached(ITransportClient* client);
+    void lowWaterMarkReached(ITransportClient* client);
+
+    // emitted on the replying thread once a reply is handed over for writing
+    void replySent(ITransportClient* client, const QVariant& requestId);
+
+protected slots:
+    // encodes reply on client thread, protocol adapters override it
+    virtual void writeReply(const QVariant& requestId, const QVariant& value, int status);
+    void enqueue(const QByteArray& data, const QString& tag = QString());
+
+private slots:
+    // data already counted as pending by post()
+    void enqueuePosted(const QByteArray& data, const QString& tag);
+    void enqueuePostedFrame(const QByteArray& data, const QString& tag);
+    void enqueueStreamChunk(const QByteArray& data, bool last);
+    void drain();
+    void onBytesWritten(ITransportClient* client, qint64 bytes);
+    void dropQueue();
+
+private:
+    QByteArray encodeFrame(const QByteArray& data);
+    void updatePendingBytes(qint64 delta);
+    void appendToQueue(const QByteArray& data, const QString& tag);
+
+    struct PendingWrite
+    {
+        QByteArray data;
+        QString tag;
+        // bytes already handed to socket
+        int offset = 0;
+    };
+
+    // data is handed to socket in portions of at most s_socketChunk once socket buffer is below
+    // it, so large replies are not copied into socket at once and later data can still coalesce
+    static const qint64 s_socketChunk = 256 * 1024;
+
+    QList<PendingWrite> m_outQueue;
+    // data posted while a streamed reply is open, not counted as pending until released
+    QList<PendingWrite> m_heldQueue;
+    bool m_streamOpen = false;
+    bool m_draining = false;
+    qint64 m_socketBytes = 0;
+    QAtomicInteger<qint64> m_pendingBytes;
+    QAtomicInteger<qint64> m_highWaterMark;
+    QAtomicInteger<qint64> m_lowWaterMark;
+    QAtomicInt m_backpressured;
+
+    QAFrameDecoder m_decoder;
+    QAFrameDecoder::Mode m_negotiatedFraming = QAFrameDecoder::JsonMode;
+    Encoding m_negotiatedEncoding = JsonEncoding;
+    Encoding m_encoding = JsonEncoding;
+    bool m_negotiatedStreaming = false;
+    QAtomicInt m_streaming;
+    QVariantMap m_connectionOptions;
+    QScopedPointer<QASharedMemoryChannel> m_sharedMemory;
+    QScopedPointer<QACompressor> m_negotiatedCompressor;
+    QScopedPointer<QACompressor> m_compressor;
+
+    // ids of commands being dispatched, nested event loops may stack them
+    QVariantList m_requestIds;
 };
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <qt_qa_engine/QACommand.h>
+
 #include <QHash>
 #include <QObject>
+#include <QVariantMap>
 
 class ITransportClient;
 class ITransportServer : public QObject
@@ -14,8 +17,12 @@ public:
     virtual void readData(ITransportClient* client);
 
 signals:
-    void commandReceived(ITransportClient* client, const QByteArray& cmd);
+    void commandReceived(ITransportClient* client, const QACommand& command);
+    // emitted before any command of the client, again on every reconnect of a reused client
+    void clientAdded(ITransportClient* client);
     void clientLost(ITransportClient* client);
+    // address clients can connect to, e.g. {"port": 8888} or {"socket": "/tmp/qa.sock"}
+    void listening(ITransportServer* server, const QVariantMap& address);
 
 public slots:
     virtual void start() = 0;
@@ -0,0 +1,29 @@
+#pragma once
+#include <qt_qa_engine/ITransportClient.h>
+
+class QLocalSocket;
+class LocalSocketClient : public ITransportClient
+{
+    Q_OBJECT
+public:
+    explicit LocalSocketClient(QLocalSocket* socket, QObject* parent = nullptr);
+    qint64 bytesAvailable() override;
+    QByteArray readAll() override;
+    bool isOpen() override;
+    bool isConnected() override;
+    void close() override;
+    qint64 write(const QByteArray& data) override;
+    bool flush() override;
+    qint64 bytesToWrite() override;
+    bool waitForBytesWritten(int msecs) override;
+    bool waitForReadyRead(int msecs) override;
+
+private slots:
+    void onDisconnected();
+    void onConnected();
+    void onReadyRead();
+    void onBytesWritten(qint64 bytes);
+
+private:
+    QLocalSocket* m_socket = nullptr;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <qt_qa_engine/ITransportServer.h>
+
+#include <QObject>
+
+class QLocalServer;
+class LocalSocketServer : public ITransportServer
+{
+    Q_OBJECT
+public:
+    static const int s_probeTimeout = 1000;
+
+    explicit LocalSocketServer(const QString& name, QObject* parent = nullptr);
+    ~LocalSocketServer() override;
+
+public slots:
+    void start() override;
+
+private slots:
+    void newConnection();
+
+private:
+    // another process is listening on m_name
+    bool isServerAlive() const;
+
+    QString m_name;
+    QLocalServer* m_server = nullptr;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <qt_qa_engine/ITransportClient.h>
+
+#include <QPointer>
+#include <QVariantList>
+
+#include <functional>
+
+class QAPendingEvent;
+class QTimer;
+
+// runs batch items one by one as if they came from client, collecting replies into one array
+class QABatch : public ITransportClient
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(ITransportClient*, const QString&, const QVariantList&)> Dispatcher;
+
+    // item which does not reply for that long fails with timeout status
+    static const int s_itemTimeout = 60000;
+
+    QABatch(ITransportClient* client,
+            const QVariant& requestId,
+            const QVariantList& items,
+            const QVariantMap& options,
+            const Dispatcher& dispatcher,
+            QObject* parent = nullptr);
+
+    qint64 bytesAvailable() override;
+    QByteArray readAll() override;
+    bool isOpen() override;
+    bool isConnected() override;
+    void close() override;
+    qint64 write(const QByteArray& data) override;
+    bool flush() override;
+    qint64 bytesToWrite() override;
+    bool waitForBytesWritten(int msecs) override;
+    bool waitForReadyRead(int msecs) override;
+
+    QVariant payloadValue(const QByteArray& payload) override;
+    ITransportClient* sessionClient() override;
+    // pending events of items are tracked under the batch, apart from ids of the client
+    QVariant sessionRequestId() const override;
+
+public slots:
+    void start();
+
+protected slots:
+    void writeReply(const QVariant& requestId, const QVariant& value, int status) override;
+
+private slots:
+    void runNext();
+    void onCancelled();
+    void onItemTimeout();
+
+private:
+    QVariant resolve(const QVariant& param, QString* error) const;
+    void finish();
+
+    QPointer<ITransportClient> m_client;
+    QVariant m_requestId;
+    QVariantList m_items;
+    bool m_stopOnError = true;
+    Dispatcher m_dispatcher;
+
+    QVariantList m_results;
+    int m_current = -1;
+
+    // tracked under the batch request id, cancel with that id or deadline stops the batch
+    QAPendingEvent* m_pending = nullptr;
+    QTimer* m_itemTimer = nullptr;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QString>
+#include <QVariant>
+
+struct QACommand
+{
+    QVariant id;
+    QString action;
+    QVariantList params;
+
+    // started when command is decoded, elapsed() at dispatch is the time spent queued
+    QElapsedTimer received;
+    // msecs after received, -1 for no deadline
+    qint64 deadline = -1;
+    // command without id taken from the session backlog, it already holds the slot
+    bool admitted = false;
+
+    bool isValid() const;
+    bool isExpired() const;
+    qint64 remainingTime() const;
+
+    // invalid command without error for well-formed frames which are not actions
+    static QACommand fromJson(const QByteArray& data, QString* errorString = nullptr);
+};
+
+Q_DECLARE_METATYPE(QACommand)
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+struct z_stream_s;
+struct ZSTD_CCtx_s;
+
+class QACompressor
+{
+public:
+    enum Method
+    {
+        NoCompression,
+        QCompressMethod,
+        ZlibStreamMethod,
+        ZstdStreamMethod,
+    };
+
+    static const int s_defaultThreshold = 1024;
+
+    static QStringList availableMethods();
+    static Method methodFromName(const QString& name);
+    static QString methodName(Method method);
+
+    // level for payloads compressed with qCompress before base64, QAENGINE_COMPRESSION_LEVEL
+    static int payloadLevel();
+
+    QACompressor(Method method, int level = -1, int threshold = s_defaultThreshold);
+    ~QACompressor();
+
+    bool isValid() const;
+    Method method() const;
+    int level() const;
+    int threshold() const;
+
+    // stream methods keep context between calls, frames must be decompressed in order
+    bool compress(const QByteArray& data, QByteArray* compressed);
+
+private:
+    Q_DISABLE_COPY(QACompressor)
+
+    Method m_method = NoCompression;
+    int m_level = -1;
+    int m_threshold = s_defaultThreshold;
+    bool m_valid = false;
+
+    z_stream_s* m_zlib = nullptr;
+    ZSTD_CCtx_s* m_zstd = nullptr;
+};
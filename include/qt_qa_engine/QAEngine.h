@@ -1,12 +1,19 @@
 #pragma once
 
+#include <qt_qa_engine/QACommand.h>
+
 #include <QObject>
 #include <QVariant>
 
+#include <functional>
+
 class QAEngineSocketClient;
+class QARegistry;
+class QASession;
 class ITransportClient;
 class ITransportServer;
 class IEnginePlatform;
+class QThread;
 class QWindow;
 class QAEngine : public QObject
 {
@@ -16,6 +23,9 @@ public:
     static bool isLoaded();
     static void objectCreated(QObject* o);
     static void objectRemoved(QObject* o);
+    // GUI thread, applies queued removals of objects destroyed on other threads, must run
+    // before an object is registered, its address may be reused from one of them
+    static void flushRemovedObjects();
     IEnginePlatform* getPlatform(bool silent = false);
 
     virtual ~QAEngine();
@@ -36,24 +46,41 @@ public:
     void addItem(QObject* o);
     void removeItem(QObject* o);
 
+    // native execute_script handler, runs on GUI thread and returns the reply value,
+    // QAPendingEvent* wrapped in QVariant replies once the event completes
+    using CommandHandler =
+        std::function<QVariant(QASession& session, const QVariantList& params)>;
+
+    // command is matched exactly as passed to execute_script, e.g. "app:loadFixture",
+    // registered commands take precedence over built-in ones, thread safe
+    static void registerCommand(const QString& command, const CommandHandler& handler);
+    static void unregisterCommand(const QString& command);
+    static CommandHandler registeredCommand(const QString& command);
+
 public slots:
     void initializeSocket();
     void initializeEngine();
 
 private slots:
     void onFocusWindowChanged(QWindow* window);
-    void processCommand(ITransportClient* socket, const QByteArray& cmd);
+    void processCommand(ITransportClient* socket, const QACommand& command);
     bool processAppiumCommand(ITransportClient* socket,
                               const QString& action,
                               const QVariantList& params);
     void onPlatformReady();
+    void clientAdded(ITransportClient* client);
     void clientLost(ITransportClient* client);
+    void onServerListening(ITransportServer* server, const QVariantMap& address);
+    void drainRemovedObjects();
 
 private:
     explicit QAEngine(QObject* parent = nullptr);
-    ITransportServer* m_socketServer = nullptr;
+    void dispatchCommand(ITransportClient* socket, QASession* session, const QACommand& command);
 
-    bool m_analyzeActive = false;
-    ITransportClient* m_analyzeSocket = nullptr;
+    ITransportServer* m_socketServer = nullptr;
+    ITransportServer* m_webDriverServer = nullptr;
+    ITransportServer* m_bridgeClient = nullptr;
+    QThread* m_transportThread = nullptr;
+    QARegistry* m_registry = nullptr;
 };
 
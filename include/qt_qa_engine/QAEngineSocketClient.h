@@ -1,25 +1,60 @@
 #pragma once
 
-#include <QByteArray>
+#include <qt_qa_engine/ITransportServer.h>
+
+#include <QAbstractSocket>
+#include <QLocalSocket>
 #include <QObject>
 
+class QTimer;
 class ITransportClient;
-class QAEngineSocketClient : public QObject
+// reverse connection: engine connects to the bridge and serves commands coming from it
+class QAEngineSocketClient : public ITransportServer
 {
     Q_OBJECT
 public:
-    explicit QAEngineSocketClient(QObject* parent = nullptr);
+    static const int s_minRetryDelay = 500;
+    static const int s_maxRetryDelay = 30000;
+    static const int s_connectTimeout = 5000;
+    static const int s_defaultHeartbeatInterval = 10000;
+
+    // "host:port" for TCP, anything else is a local socket name,
+    // silenceTimeout > 0 drops the connection when the bridge sends nothing for that long
+    explicit QAEngineSocketClient(const QString& endpoint,
+                                  int heartbeatInterval = s_defaultHeartbeatInterval,
+                                  int silenceTimeout = 0,
+                                  QObject* parent = nullptr);
 
-signals:
-    void commandReceived(ITransportClient* socket, const QByteArray& cmd);
+    void readData(ITransportClient* client) override;
 
 public slots:
+    void start() override;
     void connectToBridge();
 
 private slots:
-    void readClient(ITransportClient* client);
+    void onTcpStateChanged(QAbstractSocket::SocketState state);
+    void onLocalStateChanged(QLocalSocket::LocalSocketState state);
     void onConnected();
+    void onUnconnected();
+    void sendHeartbeat();
+    void onSilenceTimeout();
 
 private:
+    void scheduleReconnect();
+    void abortConnection();
+
+    QString m_endpoint;
+    QString m_host;
+    quint16 m_port = 0;
+
+    QAbstractSocket* m_tcpSocket = nullptr;
+    QLocalSocket* m_localSocket = nullptr;
     ITransportClient* m_client = nullptr;
+    bool m_connected = false;
+
+    QTimer* m_reconnectTimer = nullptr;
+    QTimer* m_connectTimer = nullptr;
+    QTimer* m_heartbeatTimer = nullptr;
+    QTimer* m_silenceTimer = nullptr;
+    int m_retryDelay = s_minRetryDelay;
 };
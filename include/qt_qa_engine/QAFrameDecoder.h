@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+
+class QAFrameDecoder
+{
+public:
+    enum Mode
+    {
+        JsonMode,
+        LengthPrefixedMode,
+    };
+
+    static const int s_headerSize = 4;
+    static const quint32 s_maxFrameSize = 256 * 1024 * 1024;
+    // set in length header of frames compressed with negotiated connection compression
+    static const quint32 s_compressedFlag = 0x80000000u;
+
+    Mode mode() const;
+    void setMode(Mode mode);
+
+    void append(const QByteArray& data);
+    bool takeFrame(QByteArray* frame);
+
+    bool hasError() const;
+    int bufferedBytes() const;
+    void clear();
+
+    static QByteArray encodeFrame(const QByteArray& payload, Mode mode, bool compressed = false);
+
+private:
+    bool takeJsonFrame(QByteArray* frame);
+    bool takeLengthPrefixedFrame(QByteArray* frame);
+    void consume(int bytes);
+
+    QByteArray m_buffer;
+    int m_offset = 0;
+    Mode m_mode = JsonMode;
+    bool m_error = false;
+
+    // incremental JSON scanner state, m_scan is the first byte not inspected yet
+    int m_scan = 0;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QString>
+
+class QObject;
+
+// element handles are 64-bit (generation << 32 | slot) values formatted as
+// "<ClassName>_0x<16 hex digits>". The string is built once per object and cached,
+// a slot freed by object destruction gets a new generation, so stale ids never resolve
+// to an object reusing the address. GUI thread only, except hasHandles().
+class QAHandleTable
+{
+public:
+    static QString id(QObject* object);
+    // nullptr for unknown, malformed or stale ids
+    static QObject* object(const QString& id);
+    static void remove(QObject* object);
+
+    static int count();
+    // thread safe, objects destroyed on any thread have to be removed while it is true
+    static bool hasHandles();
+
+    static quint64 handle(const QString& id, bool* ok = nullptr);
+};
@@ -1,13 +1,16 @@
 #ifndef QAKEYMOUSEENGINE_H
 #define QAKEYMOUSEENGINE_H
 
+#include <QHash>
 #include <QObject>
 #include <QPointF>
+#include <QPointer>
 #include <QTouchEvent>
 #include <QVariant>
 
 class QAPendingEvent;
 class QElapsedTimer;
+class QEventLoop;
 class QTimer;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 class QPointingDevice;
@@ -45,7 +48,7 @@ public:
                          int moveSteps = 20,
                          int releaseDelay = 600);
 
-    void pressEnter();
+    QAPendingEvent* pressEnter();
 
     QAPendingEvent* performMultiAction(const QVariantList& multiActions);
     QAPendingEvent* performTouchAction(const QVariantList& actions);
@@ -104,20 +107,34 @@ private:
     QPoint m_previousPoint;
 };
 
+// element ids of the actions, resolved on the GUI thread while the command is dispatched
+typedef QHash<QString, QPointer<QObject>> EventWorkerElements;
+
 class EventWorker : public QObject
 {
     Q_OBJECT
 public:
-    explicit EventWorker(const QVariantList& actions);
+    explicit EventWorker(const QVariantList& actions,
+                         const EventWorkerElements& elements = EventWorkerElements());
     virtual ~EventWorker();
-    static EventWorker* PerformTouchAction(const QVariantList& actions);
-    static EventWorker* PerformChainAction(const QVariantList& actions);
+    static EventWorker* PerformTouchAction(const QVariantList& actions,
+                                           const EventWorkerElements& elements);
+    static EventWorker* PerformChainAction(const QVariantList& actions,
+                                           const EventWorkerElements& elements);
+
+    // collects the "element" and "origin" ids of the actions, call during dispatch
+    static EventWorkerElements ResolveElements(const QVariant& actions);
 
 public slots:
     void start();
     void startChain();
+    // interrupts the sequence at the next step or wait, queued from other threads
+    void stop();
 
 private:
+    // false if stopped while waiting
+    bool wait(int msecs);
+
     void sendPress(const QPointF& point);
     void sendRelease(const QPointF& point);
     void sendMove(const QPointF& point);
@@ -125,7 +142,13 @@ private:
 
     QList<QPointF> moveInterpolator(const QPointF& previousPoint, const QPointF& point, int moveSteps);
 
+    // center of the resolved element, fallback when it is unknown or destroyed
+    QPointF elementCenter(const QString& elementId, const QPointF& fallback) const;
+
     QVariantList m_actions;
+    EventWorkerElements m_elements;
+    bool m_stopped = false;
+    QEventLoop* m_wait = nullptr;
 
 signals:
     void pressed(const QPointF &point);
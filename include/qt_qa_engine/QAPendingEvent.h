@@ -9,10 +9,26 @@ class QAPendingEvent : public QObject
 public:
     explicit QAPendingEvent(QObject *parent = nullptr);
 
+    bool isCompleted() const;
+    bool isCancelled() const;
+    QVariant result() const;
+    void setResult(const QVariant& result);
+    // reply status, non zero for cancelled events
+    int status() const;
+
 signals:
+    // producers stop their work on cancelled(), completed() follows right after
+    void cancelled(QAPendingEvent *pending);
     void completed(QAPendingEvent *pending);
 
 public slots:
     void setCompleted();
+    void cancel(const QString& reason = QStringLiteral("cancelled"), int status = 1);
+
+private:
+    bool m_completed = false;
+    bool m_cancelled = false;
+    int m_status = 0;
+    QVariant m_result;
 };
 
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+// publishes engine endpoint as <pid>.json in a directory orchestrators can enumerate,
+// <pid>.ready appears once a platform is ready to serve commands
+class QARegistry
+{
+public:
+    explicit QARegistry(const QString& directory);
+    ~QARegistry();
+
+    bool isValid() const;
+    QString directory() const;
+
+    // merged into published record, e.g. {"port": 8888} or {"socket": "/tmp/qa.sock"}
+    void setAddress(const QVariantMap& address);
+    void setWindows(const QVariantList& windows);
+    void markReady();
+
+    void remove();
+
+private:
+    bool publish();
+    QString filePath(const QString& suffix) const;
+    void removeStaleEntries();
+
+    QString m_directory;
+    QVariantMap m_record;
+    bool m_valid = false;
+    bool m_ready = false;
+};
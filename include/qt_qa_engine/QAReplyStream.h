@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QIODevice>
+#include <QPointer>
+#include <QVariant>
+
+#include <functional>
+
+class ITransportClient;
+class QTimer;
+
+// writes JSON reply to client in bounded chunks while the value is still being produced,
+// producer is paused between steps while client output is above its high water mark
+class QAReplyStream : public QIODevice
+{
+    Q_OBJECT
+public:
+    enum ValueType
+    {
+        // written data is escaped into JSON string
+        StringValue,
+        // written data is JSON value itself
+        JsonValue,
+    };
+
+    static const int s_chunkSize = 64 * 1024;
+    // peer which does not read for that long loses the connection, the reply is truncated
+    static const int s_drainTimeout = 30000;
+
+    QAReplyStream(ITransportClient* client,
+                  const QVariant& requestId,
+                  ValueType type,
+                  QObject* parent = nullptr);
+    ~QAReplyStream() override;
+
+    // terminates the reply, nothing can be written after
+    void finish();
+    // calls step until it returns false, then finishes the reply and deletes the stream.
+    // While the client is backpressured the thread goes back to its event loop and steps
+    // resume once the client drains to its low water mark. Streams must be heap allocated
+    void start(const std::function<bool()>& step);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private slots:
+    void resume();
+    void abort();
+    void onDrainTimeout();
+
+private:
+    void flushChunk(bool last = false);
+
+    QPointer<ITransportClient> m_client;
+    QVariant m_requestId;
+    ValueType m_type;
+    QByteArray m_chunk;
+    std::function<bool()> m_step;
+    QTimer* m_drainTimer = nullptr;
+    bool m_paused = false;
+    bool m_aborted = false;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <qt_qa_engine/QACommand.h>
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QVariantList>
+
+class ITransportClient;
+class QAPendingEvent;
+class QASession : public QObject
+{
+    Q_OBJECT
+public:
+    // session of a connected client, created on first use
+    static QASession* forClient(ITransportClient* client);
+    static QASession* find(ITransportClient* client);
+    static void close(ITransportClient* client);
+    static QList<QASession*> sessions();
+    // removeItem for every session, called for each destroyed object
+    static void removeItemFromSessions(QObject* platform, QObject* item);
+    // any element handle given out, thread safe
+    static bool hasTrackedItems();
+
+    // session of the command being dispatched, nullptr outside of dispatch and off GUI thread
+    static QASession* current();
+
+    class Scope
+    {
+    public:
+        explicit Scope(QASession* session);
+        ~Scope();
+
+    private:
+        QASession* m_previous = nullptr;
+    };
+
+    ITransportClient* client() const;
+
+    // element handles are kept per platform, ids resolve in the window they were found in,
+    // removal is a lookup in the reverse index, untracked objects cost one hash probe
+    void insertItem(QObject* platform, const QString& elementId, QObject* item);
+    QObject* item(QObject* platform, const QString& elementId) const;
+    bool containsItem(QObject* platform, const QString& elementId) const;
+    void removeItem(QObject* platform, QObject* item);
+
+    QVariantList lastFilters() const;
+    void setLastFilters(const QVariantList& filters);
+
+    struct SignalRegistration
+    {
+        QPointer<QObject> item;
+        QString signalName;
+        int count = 0;
+    };
+
+    // keys are "<elementId>_<signal>"
+    void registerSignal(const QString& key, QObject* item, const QString& signalName);
+    void unregisterSignal(const QString& key);
+    bool hasSignal(const QString& key) const;
+    void countSignal(const QString& key);
+    int signalCount(const QString& key) const;
+    QHash<QString, SignalRegistration> signalRegistrations() const;
+
+    bool isAnalyzeActive() const;
+    void setAnalyzeActive(bool active);
+
+    // replies to commands without id can only be matched by order, so such commands
+    // run one at a time: false means the command is queued until the previous one replied
+    bool admitCommand(const QACommand& command);
+    // command without id which returns from dispatch without replying releases its slot,
+    // unless the handler called deferReply() to reply later
+    void beginDispatch(const QACommand& command);
+    void deferReply();
+    void endDispatch();
+
+    // reply status of commands cut by their deadline
+    static const int s_timeoutStatus = 21;
+
+    // deadline of the command being dispatched applies to pending events it starts
+    void setCommandDeadline(qint64 remainingMsecs);
+    void trackPending(const QVariant& requestId, QAPendingEvent* pending);
+    // cancels pending events of requestId, all of them for invalid requestId
+    int cancel(const QVariant& requestId,
+               const QString& reason = QStringLiteral("cancelled"),
+               int status = 1);
+
+signals:
+    // queued command without id may run now
+    void commandReady(ITransportClient* client, const QACommand& command);
+
+private slots:
+    void onReplySent(ITransportClient* client, const QVariant& requestId);
+
+private:
+    explicit QASession(ITransportClient* client, QObject* parent = nullptr);
+    ~QASession() override;
+
+    ITransportClient* m_client = nullptr;
+
+    QHash<QObject*, QHash<QString, QObject*>> m_items;
+    // item -> platform -> elementId, reverse of m_items
+    QHash<QObject*, QHash<QObject*, QString>> m_itemIds;
+    QVariantList m_lastFilters;
+    QHash<QString, SignalRegistration> m_signals;
+    bool m_analyzeActive = false;
+
+    void releaseAnonymous();
+
+    bool m_anonymousInFlight = false;
+    QQueue<QACommand> m_anonymousBacklog;
+    bool m_dispatchingAnonymous = false;
+    bool m_anonymousReplied = false;
+    bool m_replyDeferred = false;
+
+    struct PendingRequest
+    {
+        QVariant requestId;
+        QPointer<QAPendingEvent> event;
+    };
+    QList<PendingRequest> m_pending;
+    qint64 m_commandDeadline = -1;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QQueue>
+#include <QSharedMemory>
+#include <QString>
+#include <QVariantMap>
+
+// payloads stay in the ring until the reader releases them: it stores sequence of the last
+// payload it copied out into the first 8 bytes of the segment, payloads are released in order
+class QASharedMemoryChannel
+{
+public:
+    static const int s_defaultSize = 64 * 1024 * 1024;
+    static const int s_maxSize = 1024 * 1024 * 1024;
+    // control block in front of payloads, offset 0 is released sequence written by the reader
+    static const int s_headerSize = 64;
+
+    explicit QASharedMemoryChannel(int size);
+
+    bool isValid() const;
+    int size() const;
+
+    QVariantMap description() const;
+
+    // copies payload into the ring and returns handle map, or invalid QVariant if it does not fit
+    // next to payloads the reader has not released yet
+    QVariant write(const QByteArray& payload);
+
+private:
+    void releaseRegions();
+    int allocate(int length) const;
+
+    struct Region
+    {
+        int offset;
+        int length;
+        quint64 sequence;
+    };
+
+    QSharedMemory m_memory;
+    // written and not released yet, in ring order
+    QQueue<Region> m_regions;
+    quint64 m_sequence = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+// log-linear latency histogram in microseconds, 16 sub-buckets per power of two (~6% error)
+class QAHistogram
+{
+public:
+    static const int s_subBucketBits = 4;
+    static const int s_subBuckets = 1 << s_subBucketBits;
+    static const int s_maxExponent = 36;
+    static const int s_bucketCount = (s_maxExponent - s_subBucketBits + 2) * s_subBuckets;
+
+    QAHistogram();
+
+    void record(qint64 usecs);
+    void reset();
+
+    qint64 count() const;
+    qint64 percentile(double percent) const;
+    // {count, mean, p50, p90, p99, max} in microseconds
+    QVariantMap summary() const;
+
+private:
+    static int bucketIndex(qint64 usecs);
+    static qint64 bucketValue(int index);
+
+    QAtomicInteger<quint32> m_buckets[s_bucketCount];
+    QAtomicInteger<qint64> m_count;
+    QAtomicInteger<qint64> m_sum;
+    QAtomicInteger<qint64> m_max;
+};
+
+// named histograms, thread safe; a key resolved once records with a few atomic increments
+class QAStats
+{
+public:
+    // histogram and trace name of a key, both live as long as the process
+    struct Key
+    {
+        QAHistogram* histogram = nullptr;
+        const char* traceName = nullptr;
+    };
+
+    // thread local cache in front of the shared registry,
+    // fixed keys should keep the result, e.g. in a static at the call site
+    static Key key(const QString& name);
+
+    static void record(const Key& key, qint64 nsecs);
+    static void record(const QString& key, qint64 nsecs);
+    static QVariantMap summary();
+    static void reset();
+
+    // records time from construction to destruction
+    class Timer
+    {
+    public:
+        explicit Timer(const Key& key);
+        explicit Timer(const QString& key);
+        ~Timer();
+
+        // keys must come from a bounded set, names sent by clients are recorded once resolved
+        void setKey(const QString& key);
+
+    private:
+        Key m_key;
+        QElapsedTimer m_timer;
+    };
+};
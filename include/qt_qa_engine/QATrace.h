@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// spans of engine activity in Chrome trace_event format, open the file in chrome://tracing
+// or Perfetto. Recording appends to a buffer of the calling thread without locks,
+// disabled tracing costs one atomic load.
+class QATrace
+{
+public:
+    static const int s_chunkSize = 4096;
+    static const int s_maxChunks = 64;
+    // threads recording at the same time, finished threads hand their buffer over
+    static const int s_maxBuffers = 64;
+
+    static bool isEnabled();
+    // drops events of the previous trace
+    static void start();
+    static void stop();
+
+    // names must outlive the trace: string literals or intern()
+    static void record(const char* name, qint64 startNsecs, qint64 durationNsecs);
+    static const char* intern(const QString& name);
+    // monotonic nanoseconds, the time base of recorded spans
+    static qint64 now();
+
+    // call while no other thread starts a new trace
+    static QByteArray toJson();
+    static bool save(const QString& filePath);
+
+    // records time from construction to destruction
+    class Span
+    {
+    public:
+        explicit Span(const char* name);
+        ~Span();
+
+    private:
+        const char* m_name = nullptr;
+        qint64 m_start = 0;
+    };
+};
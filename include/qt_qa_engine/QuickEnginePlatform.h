@@ -46,7 +46,7 @@ protected:
                         QObject* item,
                         bool fillBackground = false) override;
 
-    void pressAndHoldItem(QObject* qitem, int delay = 800) override;
+    QAPendingEvent* pressAndHoldItem(QObject* qitem, int delay = 800) override;
     void clearFocus();
     void clearComponentCache();
 
@@ -14,6 +14,7 @@ public:
     void close() override;
     qint64 write(const QByteArray& data) override;
     bool flush() override;
+    qint64 bytesToWrite() override;
     bool waitForBytesWritten(int msecs) override;
     bool waitForReadyRead(int msecs) override;
 
@@ -21,6 +22,7 @@ private slots:
     void onDisconnected();
     void onConnected();
     void onReadyRead();
+    void onBytesWritten(qint64 bytes);
 
 private:
     QTcpSocket* m_socket = nullptr;
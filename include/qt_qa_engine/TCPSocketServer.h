@@ -9,8 +9,14 @@ class TCPSocketServer : public ITransportServer
 {
     Q_OBJECT
 public:
+    static const int s_portProbes = 10;
+
     explicit TCPSocketServer(quint16 port = 8888, QObject* parent = nullptr);
 
+    // when none of the probed ports is free, listen on one chosen by the system,
+    // only useful when the actual port is published, e.g. by the registry
+    void setEphemeralFallback(bool enabled);
+
 public slots:
     void start();
 
@@ -20,4 +26,5 @@ private slots:
 private:
     quint16 m_port = 8888;
     QTcpServer* m_server = nullptr;
+    bool m_ephemeralFallback = false;
 };
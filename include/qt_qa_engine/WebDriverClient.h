@@ -0,0 +1,56 @@
+#pragma once
+#include <qt_qa_engine/TCPSocketClient.h>
+
+#include <QHash>
+#include <QMap>
+
+struct WebDriverRequest
+{
+    QByteArray method;
+    QByteArray path;
+    QByteArray body;
+};
+
+class WebDriverClient : public TCPSocketClient
+{
+    Q_OBJECT
+public:
+    static const int s_maxHeaderSize = 64 * 1024;
+
+    // what a request expects, picks W3C error codes and shapes the reply value
+    enum RequestKind
+    {
+        PlainRequest,
+        ElementRequest,
+        FindElementRequest,
+        FindElementsRequest,
+        ScriptRequest,
+    };
+
+    explicit WebDriverClient(QTcpSocket* socket, QObject* parent = nullptr);
+
+    void append(const QByteArray& data);
+    bool takeRequest(WebDriverRequest* request);
+    bool hasError() const;
+
+    // responses are written in request order, whatever order commands complete in
+    qint64 nextRequestId();
+    void setRequestKind(qint64 requestId, RequestKind kind);
+    void sendError(qint64 requestId, int httpStatus, const QString& error, const QString& message);
+
+protected slots:
+    void writeReply(const QVariant& requestId, const QVariant& value, int status) override;
+
+private:
+    void queueResponse(qint64 requestId, int httpStatus, const QByteArray& body);
+
+    QByteArray m_buffer;
+    bool m_error = false;
+
+    qint64 m_nextRequestId = 0;
+    qint64 m_nextResponseId = 0;
+    QMap<qint64, QByteArray> m_readyResponses;
+
+    // requests of other kinds than PlainRequest
+    QHash<qint64, RequestKind> m_requestKinds;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <qt_qa_engine/ITransportServer.h>
+#include <qt_qa_engine/WebDriverClient.h>
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+class QTcpServer;
+class WebDriverSession;
+class WebDriverServer : public ITransportServer
+{
+    Q_OBJECT
+public:
+    explicit WebDriverServer(quint16 port, QObject* parent = nullptr);
+
+    void readData(ITransportClient* client) override;
+
+public slots:
+    void start() override;
+
+private slots:
+    void newConnection();
+
+private:
+    void handleRequest(WebDriverClient* client, const WebDriverRequest& request);
+    bool route(const QByteArray& method,
+               const QStringList& path,
+               const QVariantMap& body,
+               QString* action,
+               QVariantList* params,
+               WebDriverClient::RequestKind* kind);
+
+    quint16 m_port = 0;
+    QTcpServer* m_server = nullptr;
+    // created by POST /session, element ids of any connection resolve in their session
+    QHash<QString, WebDriverSession*> m_sessions;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <qt_qa_engine/ITransportClient.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+
+class WebDriverClient;
+
+// W3C session commands run in, so element ids outlive the connection which found them.
+// Lives on the GUI thread and hands replies back to the connection each request came from
+class WebDriverSession : public ITransportClient
+{
+    Q_OBJECT
+public:
+    explicit WebDriverSession(const QString& id, QObject* parent = nullptr);
+
+    QString id() const;
+    // session wide id for a request of the connection, thread safe
+    qint64 addRequest(WebDriverClient* client, qint64 clientRequestId);
+
+    qint64 bytesAvailable() override;
+    QByteArray readAll() override;
+    bool isOpen() override;
+    bool isConnected() override;
+    void close() override;
+    qint64 write(const QByteArray& data) override;
+    bool flush() override;
+    qint64 bytesToWrite() override;
+    bool waitForBytesWritten(int msecs) override;
+    bool waitForReadyRead(int msecs) override;
+
+protected slots:
+    void writeReply(const QVariant& requestId, const QVariant& value, int status) override;
+
+private:
+    struct Request
+    {
+        QPointer<WebDriverClient> client;
+        qint64 requestId = 0;
+    };
+
+    QString m_id;
+    QMutex m_requestsMutex;
+    qint64 m_nextRequestId = 0;
+    QHash<qint64, Request> m_requests;
+};
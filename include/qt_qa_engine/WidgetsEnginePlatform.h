@@ -42,7 +42,7 @@ protected:
                         QObject* item,
                         bool fillBackground = false) override;
 
-    void pressAndHoldItem(QObject* qitem, int delay = 800) override;
+    QAPendingEvent* pressAndHoldItem(QObject* qitem, int delay = 800) override;
 
     QHash<QObject*, QWidget*> m_rootWidgets;
     QWidget* m_rootWidget = nullptr;
@@ -36,6 +36,18 @@ qtHaveModule(xmlpatterns) {
     DEFINES += MO_USE_QXMLPATTERNS
 }
 
+unix:packagesExist(zlib) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += zlib
+    DEFINES += MO_USE_ZLIB
+}
+
+unix:packagesExist(libzstd) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+    DEFINES += MO_USE_ZSTD
+}
+
 qtHaveModule(qml) {
     QT += qml quick quick-private
     DEFINES += MO_USE_QUICK
@@ -57,12 +69,28 @@ SOURCES += \
     src/IEnginePlatform.cpp \
     src/ITransportClient.cpp \
     src/ITransportServer.cpp \
+    src/LocalSocketClient.cpp \
+    src/LocalSocketServer.cpp \
+    src/QABatch.cpp \
+    src/QACommand.cpp \
+    src/QACompressor.cpp \
     src/QAEngine.cpp \
     src/QAEngineSocketClient.cpp \
+    src/QAFrameDecoder.cpp \
+    src/QAHandleTable.cpp \
     src/QAKeyMouseEngine.cpp \
     src/QAPendingEvent.cpp \
+    src/QARegistry.cpp \
+    src/QAReplyStream.cpp \
+    src/QASession.cpp \
+    src/QASharedMemoryChannel.cpp \
+    src/QAStats.cpp \
+    src/QATrace.cpp \
     src/TCPSocketClient.cpp \
     src/TCPSocketServer.cpp \
+    src/WebDriverClient.cpp \
+    src/WebDriverServer.cpp \
+    src/WebDriverSession.cpp \
     src/loader.cpp
 
 HEADERS += \
@@ -70,12 +98,28 @@ HEADERS += \
     include/qt_qa_engine/IEnginePlatform.h \
     include/qt_qa_engine/ITransportClient.h \
     include/qt_qa_engine/ITransportServer.h \
+    include/qt_qa_engine/LocalSocketClient.h \
+    include/qt_qa_engine/LocalSocketServer.h \
+    include/qt_qa_engine/QABatch.h \
+    include/qt_qa_engine/QACommand.h \
+    include/qt_qa_engine/QACompressor.h \
     include/qt_qa_engine/QAEngine.h \
     include/qt_qa_engine/QAEngineSocketClient.h \
+    include/qt_qa_engine/QAFrameDecoder.h \
+    include/qt_qa_engine/QAHandleTable.h \
     include/qt_qa_engine/QAKeyMouseEngine.h \
     include/qt_qa_engine/QAPendingEvent.h \
+    include/qt_qa_engine/QARegistry.h \
+    include/qt_qa_engine/QAReplyStream.h \
+    include/qt_qa_engine/QASession.h \
+    include/qt_qa_engine/QASharedMemoryChannel.h \
+    include/qt_qa_engine/QAStats.h \
+    include/qt_qa_engine/QATrace.h \
     include/qt_qa_engine/TCPSocketClient.h \
-    include/qt_qa_engine/TCPSocketServer.h
+    include/qt_qa_engine/TCPSocketServer.h \
+    include/qt_qa_engine/WebDriverClient.h \
+    include/qt_qa_engine/WebDriverServer.h \
+    include/qt_qa_engine/WebDriverSession.h
 
 INCLUDEPATH += include
 
@@ -1,8 +1,14 @@
 #include <qt_qa_engine/GenericEnginePlatform.h>
 #include <qt_qa_engine/ITransportClient.h>
 #include <qt_qa_engine/QAEngine.h>
+#include <qt_qa_engine/QACompressor.h>
+#include <qt_qa_engine/QAHandleTable.h>
 #include <qt_qa_engine/QAKeyMouseEngine.h>
 #include <qt_qa_engine/QAPendingEvent.h>
+#include <qt_qa_engine/QAReplyStream.h>
+#include <qt_qa_engine/QASession.h>
+#include <qt_qa_engine/QAStats.h>
+#include <qt_qa_engine/QATrace.h>
 
 #include <QClipboard>
 #include <QDebug>
@@ -15,6 +21,7 @@
 #include <QJsonValue>
 #include <QMetaMethod>
 #include <QRegularExpression>
+#include <QSharedPointer>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #else
 #include <QRegExp>
@@ -54,6 +61,22 @@ bool variantPairCompare(const std::pair<QString, QVariant> &lhs, const std::pair
     return variantCompare(lhs.second, rhs.second);
 }
 
+// one level of a streamed tree walk, objects may be destroyed while the stream is paused
+struct StreamedDumpLevel
+{
+    explicit StreamedDumpLevel(const QList<QObject*>& objects)
+    {
+        for (QObject* object : objects)
+        {
+            children.append(object);
+        }
+    }
+
+    QList<QPointer<QObject>> children;
+    int next = 0;
+    int written = 0;
+};
+
 GenericEnginePlatform::GenericEnginePlatform(QWindow* window)
     : IEnginePlatform(window)
     , m_rootWindow(window)
@@ -91,19 +114,50 @@ void GenericEnginePlatform::focusWindowChanged(QWindow *w)
 
 void GenericEnginePlatform::socketReply(ITransportClient* socket, const QVariant& value, int status)
 {
-    QByteArray data;
-    {
-        QJsonObject reply;
-        reply.insert(QStringLiteral("status"), status);
-        reply.insert(QStringLiteral("value"), QJsonValue::fromVariant(value));
+    deferredReply(socket, socket->requestId(), value, status);
+}
 
-        data = QJsonDocument(reply).toJson(QJsonDocument::Compact);
-    }
-    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << data.size() << "Reply is:";
-//    qCDebug(categoryGenericEnginePlatformRaw).noquote() << data;
+void GenericEnginePlatform::deferredReply(ITransportClient* socket,
+                                          const QVariant& requestId,
+                                          const QVariant& value,
+                                          int status)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << requestId << status;
+    socket->sendReply(requestId, value, status);
+}
 
-    socket->write(data);
-    socket->flush();
+QAPendingEvent* GenericEnginePlatform::completedEvent(const QVariant& result)
+{
+    QAPendingEvent* pending = new QAPendingEvent(this);
+    pending->setResult(result);
+    connect(pending, &QAPendingEvent::completed, pending, &QObject::deleteLater);
+    // complete after caller had a chance to connect
+    QMetaObject::invokeMethod(pending, "setCompleted", Qt::QueuedConnection);
+    return pending;
+}
+
+void GenericEnginePlatform::pendingReply(ITransportClient* socket, QAPendingEvent* pending)
+{
+    const QVariant requestId = socket->requestId();
+    QPointer<ITransportClient> client(socket);
+    // cancelled by id, deadline or disconnect of the client
+    QASession::forClient(socket)->trackPending(socket->sessionRequestId(), pending);
+    connect(pending,
+            &QAPendingEvent::completed,
+            this,
+            [this, client, requestId](QAPendingEvent* event)
+            {
+                // closed session means the client is gone
+                if (!client || !QASession::find(client))
+                {
+                    return;
+                }
+                const QVariant result = event->result();
+                deferredReply(client,
+                              requestId,
+                              result.isValid() ? result : QVariant(QString()),
+                              event->status());
+            });
 }
 
 void GenericEnginePlatform::elementReply(ITransportClient* socket,
@@ -118,7 +172,7 @@ void GenericEnginePlatform::elementReply(ITransportClient* socket,
             continue;
         }
         const QString uId = uniqueId(item);
-        m_items.insert(uId, item);
+        QASession::forClient(socket)->insertItem(this, uId, item);
 
         qDebug() << "!!! insert !!!" << this << item << uId << m_rootWindow;
 
@@ -148,19 +202,7 @@ void GenericEnginePlatform::addItem(QObject* o)
 
 void GenericEnginePlatform::removeItem(QObject* o)
 {
-    QHash<QString, QObject*>::iterator i = m_items.begin();
-    while (i != m_items.end())
-    {
-        if (i.value() == o)
-        {
-            i = m_items.erase(i);
-            break;
-        }
-        else
-        {
-            ++i;
-        }
-    }
+    QASession::removeItemFromSessions(this, o);
 }
 
 void GenericEnginePlatform::findElement(ITransportClient* socket,
@@ -175,8 +217,17 @@ void GenericEnginePlatform::findElement(ITransportClient* socket,
     QString fixStrategy = strategy;
     fixStrategy = fixStrategy.remove(QChar(u' ')).toLower();
     const QString methodName = QStringLiteral("findStrategy_%1").arg(fixStrategy);
-    if (!QAEngine::metaInvoke(
-            socket, this, methodName, {selector, multiple, QVariant::fromValue(item)}))
+    // unknown strategies are property names
+    static const QAStats::Key propertyKey = QAStats::key(QStringLiteral("findStrategy_property"));
+    QAStats::Timer timer(propertyKey);
+    bool implemented = false;
+    const bool found = QAEngine::metaInvoke(
+        socket, this, methodName, {selector, multiple, QVariant::fromValue(item)}, &implemented);
+    if (implemented)
+    {
+        timer.setKey(methodName);
+    }
+    if (!found)
     {
         findByProperty(socket, strategy, selector, multiple, item);
     }
@@ -204,6 +255,24 @@ QObject* GenericEnginePlatform::findItemById(const QString& id, QObject* parentI
         parentItem = rootObject();
     }
 
+    // exact ids resolve through the handle table, every valid id was issued there
+    if (!id.startsWith(QChar(u'/')) && !id.contains(QChar(u'*')))
+    {
+        QObject* item = QAHandleTable::object(id);
+        if (!item)
+        {
+            return nullptr;
+        }
+        for (QObject* ancestor = item; ancestor; ancestor = getParent(ancestor))
+        {
+            if (ancestor == parentItem)
+            {
+                return item;
+            }
+        }
+        // not reachable through parents, e.g. widget actions, fall back to traversal
+    }
+
     if (checkMatch(id, uniqueId(parentItem)))
     {
         return parentItem;
@@ -454,12 +523,20 @@ QObjectList GenericEnginePlatform::filterVisibleItems(QObjectList items)
 
 bool GenericEnginePlatform::containsObject(const QString& elementId)
 {
-    return m_items.contains(elementId);
+    return getObject(elementId);
 }
 
 QObject* GenericEnginePlatform::getObject(const QString& elementId)
 {
-    return m_items.value(elementId);
+    if (QASession* session = QASession::current())
+    {
+        QObject* item = session->item(this, elementId);
+        // handle of a destroyed object may be left behind when its hook was missed
+        return item && QAHandleTable::object(elementId) == item ? item : nullptr;
+    }
+
+    // ids are scoped to a session, input workers get theirs resolved during dispatch
+    return nullptr;
 }
 
 QString GenericEnginePlatform::getText(QObject* item)
@@ -522,10 +599,10 @@ void GenericEnginePlatform::startAnalyze(ITransportClient* socket)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
 
-    if (m_analyzeSocket)
+    if (m_analyzeClients.contains(socket))
         return;
 
-    m_analyzeSocket = socket;
+    m_analyzeClients.append(socket);
 
     if (!m_analyzeEventFilter) {
         m_analyzeEventFilter = new AnalyzeEventFilter(this);
@@ -535,16 +612,14 @@ void GenericEnginePlatform::startAnalyze(ITransportClient* socket)
     }
 }
 
-void GenericEnginePlatform::stopAnalyze()
+void GenericEnginePlatform::stopAnalyze(ITransportClient* socket)
 {
-    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO;
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
 
-    if (!m_analyzeSocket)
+    if (!m_analyzeClients.removeOne(socket))
         return;
 
-    m_analyzeSocket = nullptr;
-
-    if (m_analyzeEventFilter) {
+    if (m_analyzeClients.isEmpty() && m_analyzeEventFilter) {
         m_rootWindow->removeEventFilter(m_analyzeEventFilter);
         m_analyzeEventFilter->deleteLater();
         m_analyzeEventFilter = nullptr;
@@ -709,7 +784,128 @@ QJsonObject GenericEnginePlatform::recursiveDumpTree(QObject* rootItem, const QV
     return object;
 }
 
+bool GenericEnginePlatform::writeTreeNode(QIODevice* device,
+                                          QObject* item,
+                                          const QVariantList& filters,
+                                          int depth,
+                                          bool separator)
+{
+    const QJsonObject object = dumpObject(item, filters, depth);
+    if (object.isEmpty())
+        return false;
+
+    QByteArray json = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    // reopen the object to append children
+    json.chop(1);
+    if (separator)
+        device->write(",");
+    device->write(json);
+    device->write(",\"children\":[");
+
+    return true;
+}
+
+void GenericEnginePlatform::streamDumpTree(QAReplyStream* stream, const QVariantList& filters)
+{
+    QList<StreamedDumpLevel> levels;
+    if (writeTreeNode(stream, m_rootWindow, filters, 0, false))
+    {
+        levels.append(StreamedDumpLevel(childrenList(m_rootWindow)));
+    }
+    else
+    {
+        stream->write("{}");
+    }
+
+    // one object per step, same document as recursiveDumpTree()
+    stream->start(
+        [this, stream, filters, levels]() mutable
+        {
+            if (levels.isEmpty())
+            {
+                return false;
+            }
+            StreamedDumpLevel& level = levels.last();
+            if (level.next == level.children.size())
+            {
+                stream->write("]}");
+                levels.removeLast();
+                return !levels.isEmpty();
+            }
+
+            QObject* child = level.children.at(level.next++);
+            if (child && writeTreeNode(stream, child, filters, level.next, level.written > 0))
+            {
+                level.written++;
+                levels.append(StreamedDumpLevel(childrenList(child)));
+            }
+            return true;
+        });
+}
+
+void GenericEnginePlatform::streamDumpXml(QAReplyStream* stream)
+{
+    QSharedPointer<QXmlStreamWriter> writer(new QXmlStreamWriter(stream));
+    writer->setAutoFormatting(false);
+    writer->writeStartDocument();
+
+    QObject* root = rootObject();
+    writeXmlElement(writer.data(), root, 0);
+    QList<StreamedDumpLevel> levels;
+    levels.append(StreamedDumpLevel(childrenList(root)));
+
+    // one object per step, same document as recursiveDumpXml()
+    stream->start(
+        [this, writer, levels]() mutable
+        {
+            if (levels.isEmpty())
+            {
+                return false;
+            }
+            StreamedDumpLevel& level = levels.last();
+            if (level.next == level.children.size())
+            {
+                writer->writeEndElement();
+                levels.removeLast();
+                if (levels.isEmpty())
+                {
+                    writer->writeEndDocument();
+                    return false;
+                }
+                return true;
+            }
+
+            QObject* child = level.children.at(level.next++);
+            if (child)
+            {
+                writeXmlElement(writer.data(), child, level.written++);
+                levels.append(StreamedDumpLevel(childrenList(child)));
+            }
+            return true;
+        });
+}
+
 bool GenericEnginePlatform::recursiveDumpXml(QXmlStreamWriter* writer, QObject* rootItem, int depth)
+{
+    writeXmlElement(writer, rootItem, depth);
+
+    int z = 0;
+
+    auto children = childrenList(rootItem);
+    for (auto&& i : children)
+    {
+        if (recursiveDumpXml(writer, i, z))
+        {
+            z++;
+        }
+    }
+
+    writer->writeEndElement();
+
+    return true;
+}
+
+void GenericEnginePlatform::writeXmlElement(QXmlStreamWriter* writer, QObject* rootItem, int depth)
 {
     const QString className = getClassName(rootItem);
     writer->writeStartElement(className);
@@ -777,29 +973,14 @@ bool GenericEnginePlatform::recursiveDumpXml(QXmlStreamWriter* writer, QObject*
     {
         writer->writeCharacters(text);
     }
-
-    int z = 0;
-
-    auto children = childrenList(rootItem);
-    for (auto&& i : children)
-    {
-        if (recursiveDumpXml(writer, i, z))
-        {
-            z++;
-        }
-    }
-
-    writer->writeEndElement();
-
-    return true;
 }
 
-void GenericEnginePlatform::clickItem(QObject* item)
+QAPendingEvent* GenericEnginePlatform::clickItem(QObject* item)
 {
     const QPoint clickPos = getClickPosition(item);
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << item << clickPos;
 
-    clickPoint(clickPos.x(), clickPos.y());
+    return clickPoint(clickPos.x(), clickPos.y());
 }
 
 QString GenericEnginePlatform::getClassName(QObject* item)
@@ -811,9 +992,7 @@ QString GenericEnginePlatform::getClassName(QObject* item)
 
 QString GenericEnginePlatform::uniqueId(QObject* item)
 {
-    return QStringLiteral("%1_0x%2")
-        .arg(getClassName(item))
-        .arg(reinterpret_cast<quintptr>(item), QT_POINTER_SIZE * 2, 16, QLatin1Char('0'));
+    return QAHandleTable::id(item);
 }
 
 void GenericEnginePlatform::setProperty(ITransportClient* socket,
@@ -836,74 +1015,98 @@ void GenericEnginePlatform::setProperty(ITransportClient* socket,
     }
 }
 
-void GenericEnginePlatform::clickPoint(float posx, float posy)
+QAPendingEvent* GenericEnginePlatform::clickPoint(float posx, float posy)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << posx << posy;
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-    timer.setInterval(50);
-    connect(m_keyMouseEngine->click(QPointF(posx, posy)),
-            &QAPendingEvent::completed,
-            &timer,
-            static_cast<void (QTimer::*)()>(&QTimer::start));
-    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-    loop.exec();
+    return settledEvent(m_keyMouseEngine->click(QPointF(posx, posy)), 50);
 }
 
-void GenericEnginePlatform::clickPoint(const QPoint& pos)
+QAPendingEvent* GenericEnginePlatform::clickPoint(const QPoint& pos)
 {
-    clickPoint(pos.x(), pos.y());
+    return clickPoint(pos.x(), pos.y());
 }
 
-void GenericEnginePlatform::pressAndHold(float posx, float posy, int delay)
+QAPendingEvent* GenericEnginePlatform::pressAndHold(float posx, float posy, int delay)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << posx << posy << delay;
 
-    QEventLoop loop;
-    connect(m_keyMouseEngine->pressAndHold(QPointF(posx, posy), delay),
-            &QAPendingEvent::completed,
-            &loop,
-            &QEventLoop::quit);
-    loop.exec();
+    return settledEvent(m_keyMouseEngine->pressAndHold(QPointF(posx, posy), delay), 0);
 }
 
-void GenericEnginePlatform::mouseMove(float startx, float starty, float stopx, float stopy)
+QAPendingEvent* GenericEnginePlatform::mouseMove(float startx, float starty, float stopx, float stopy)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << startx << starty << stopx << stopy;
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setInterval(800);
-    timer.setSingleShot(true);
-    connect(m_keyMouseEngine->move(QPointF(startx, starty), QPointF(stopx, stopy)),
-            &QAPendingEvent::completed,
-            &timer,
-            static_cast<void (QTimer::*)()>(&QTimer::start));
-    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-    loop.exec();
+    return settledEvent(m_keyMouseEngine->move(QPointF(startx, starty), QPointF(stopx, stopy)),
+                        800);
 }
 
-void GenericEnginePlatform::mouseDrag(
+QAPendingEvent* GenericEnginePlatform::mouseDrag(
     float startx, float starty, float stopx, float stopy, int delay)
 {
     qCDebug(categoryGenericEnginePlatform)
         << Q_FUNC_INFO << startx << starty << stopx << stopy << delay;
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setInterval(800);
-    timer.setSingleShot(true);
-    connect(m_keyMouseEngine->drag(QPointF(startx, starty), QPointF(stopx, stopy), delay),
+    return settledEvent(
+        m_keyMouseEngine->drag(QPointF(startx, starty), QPointF(stopx, stopy), delay), 800);
+}
+
+QAPendingEvent* GenericEnginePlatform::settledEvent(QAPendingEvent* event, int msecs)
+{
+    QAPendingEvent* pending = new QAPendingEvent(this);
+    connect(pending, &QAPendingEvent::completed, pending, &QObject::deleteLater);
+    connect(pending, &QAPendingEvent::cancelled, event, [event]() { event->cancel(); });
+    connect(event,
+            &QAPendingEvent::completed,
+            pending,
+            [pending, msecs]()
+            { QTimer::singleShot(msecs, pending, &QAPendingEvent::setCompleted); });
+    return pending;
+}
+
+QAPendingEvent* GenericEnginePlatform::delayedEvent(int msecs)
+{
+    QAPendingEvent* pending = new QAPendingEvent(this);
+    connect(pending, &QAPendingEvent::completed, pending, &QObject::deleteLater);
+    QTimer::singleShot(msecs, pending, &QAPendingEvent::setCompleted);
+    return pending;
+}
+
+QAPendingEvent* GenericEnginePlatform::sequenceEvent(
+    const QList<std::function<QAPendingEvent*()>>& steps)
+{
+    if (steps.isEmpty())
+    {
+        return completedEvent(QVariant());
+    }
+
+    QAPendingEvent* pending = new QAPendingEvent(this);
+    connect(pending, &QAPendingEvent::completed, pending, &QObject::deleteLater);
+
+    QAPendingEvent* first = steps.first()();
+    connect(pending, &QAPendingEvent::cancelled, first, [first]() { first->cancel(); });
+    const QList<std::function<QAPendingEvent*()>> rest = steps.mid(1);
+    connect(first,
             &QAPendingEvent::completed,
-            &timer,
-            static_cast<void (QTimer::*)()>(&QTimer::start));
-    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-    loop.exec();
+            pending,
+            [this, pending, rest]()
+            {
+                if (pending->isCancelled())
+                {
+                    return;
+                }
+                QAPendingEvent* next = sequenceEvent(rest);
+                connect(pending, &QAPendingEvent::cancelled, next, [next]() { next->cancel(); });
+                connect(next,
+                        &QAPendingEvent::completed,
+                        pending,
+                        &QAPendingEvent::setCompleted);
+            });
+    return pending;
 }
 
-void GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg)
+QAPendingEvent* GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg)
 {
     int startX = 0;
     int startY = 0;
@@ -911,6 +1114,7 @@ void GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg
     int endY = 0;
     int delay = 800;
 
+    QList<std::function<QAPendingEvent*()>> steps;
     const QVariantList actions = actionListArg.toList();
     for (const QVariant& actionArg : actions)
     {
@@ -926,7 +1130,7 @@ void GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg
         {
             const int tapX = options.value(QStringLiteral("x")).toInt();
             const int tapY = options.value(QStringLiteral("y")).toInt();
-            clickPoint(tapX, tapY);
+            steps.append([this, tapX, tapY]() { return clickPoint(tapX, tapY); });
         }
         else if (actionName == QLatin1String("press"))
         {
@@ -940,7 +1144,8 @@ void GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg
         }
         else if (actionName == QLatin1String("release"))
         {
-            mouseDrag(startX, startY, endX, endY, delay);
+            steps.append([this, startX, startY, endX, endY, delay]()
+                         { return mouseDrag(startX, startY, endX, endY, delay); });
         }
         else if (actionName == QLatin1String("longPress"))
         {
@@ -949,15 +1154,18 @@ void GenericEnginePlatform::processTouchActionList(const QVariant& actionListArg
             {
                 continue;
             }
-            pressAndHoldItem(getObject(elementId), delay);
+            QPointer<QObject> item = getObject(elementId);
+            steps.append([this, item, delay]() { return pressAndHoldItem(item, delay); });
         }
     }
+
+    return sequenceEvent(steps);
 }
 
-bool GenericEnginePlatform::waitForPropertyChange(QObject* item,
-                                                  const QString& propertyName,
-                                                  const QVariant& value,
-                                                  int timeout)
+QAPendingEvent* GenericEnginePlatform::waitForPropertyChange(QObject* item,
+                                                             const QString& propertyName,
+                                                             const QVariant& value,
+                                                             int timeout)
 {
     qCDebug(categoryGenericEnginePlatform)
         << Q_FUNC_INFO << item << propertyName << value << timeout;
@@ -965,14 +1173,14 @@ bool GenericEnginePlatform::waitForPropertyChange(QObject* item,
     if (!item)
     {
         qCWarning(categoryGenericEnginePlatform) << "item is null" << item;
-        return false;
+        return completedEvent(false);
     }
     int propertyIndex = item->metaObject()->indexOfProperty(propertyName.toLatin1().constData());
     if (propertyIndex < 0)
     {
         qCWarning(categoryGenericEnginePlatform)
             << Q_FUNC_INFO << item << "property" << propertyName << "is not found!";
-        return false;
+        return completedEvent(false);
     }
     const QMetaProperty prop = item->metaObject()->property(propertyIndex);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
@@ -984,49 +1192,52 @@ bool GenericEnginePlatform::waitForPropertyChange(QObject* item,
     {
         qCWarning(categoryGenericEnginePlatform)
             << Q_FUNC_INFO << item << "property" << propertyName << "is not valid!";
-        return false;
+        return completedEvent(false);
     }
     const auto propValue = prop.read(item);
     if (propValue == value)
     {
         qCWarning(categoryGenericEnginePlatform)
                 << Q_FUNC_INFO << item << "property" << propertyName << "value is same!" << propValue;
-        return true;
+        return completedEvent(true);
     }
     if (!prop.hasNotifySignal())
     {
         qCWarning(categoryGenericEnginePlatform)
             << Q_FUNC_INFO << item << "property" << propertyName << "have on notifySignal!";
-        return false;
+        return completedEvent(false);
     }
-    QEventLoop loop;
-    QTimer timer;
-    item->setProperty("WaitForPropertyChangeEventLoop", QVariant::fromValue(&loop));
-    item->setProperty("WaitForPropertyChangePropertyName", propertyName);
-    item->setProperty("WaitForPropertyChangePropertyValue", value);
-    const QMetaMethod propertyChanged =
-        metaObject()->method(metaObject()->indexOfSlot("onPropertyChanged()"));
-    connect(item, prop.notifySignal(), this, propertyChanged);
-    connect(&timer, &QTimer::timeout, this, [&loop]() { loop.exit(1); });
-    timer.start(timeout);
-    int result = loop.exec();
-    disconnect(item, prop.notifySignal(), this, propertyChanged);
 
-    return result == 0;
+    return new PropertyChangeWaiter(item, prop, value, timeout, this);
 }
 
-bool GenericEnginePlatform::waitForWindowChange(int timeout)
+QAPendingEvent* GenericEnginePlatform::waitForWindowChange(int timeout)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << timeout;
 
-    QEventLoop loop;
-    QTimer timer;
-    connect(this, &GenericEnginePlatform::focusLost, &loop, &QEventLoop::quit);
-    connect(&timer, &QTimer::timeout, this, [&loop]() { loop.exit(1); });
-    timer.start(timeout);
-    int result = loop.exec();
+    QAPendingEvent* pending = new QAPendingEvent(this);
+    QTimer* timer = new QTimer(pending);
+    timer->setSingleShot(true);
+    connect(this,
+            &GenericEnginePlatform::focusLost,
+            pending,
+            [pending]()
+            {
+                pending->setResult(true);
+                pending->setCompleted();
+            });
+    connect(timer,
+            &QTimer::timeout,
+            pending,
+            [pending]()
+            {
+                pending->setResult(false);
+                pending->setCompleted();
+            });
+    connect(pending, &QAPendingEvent::completed, pending, &QObject::deleteLater);
+    timer->start(timeout);
 
-    return result == 0;
+    return pending;
 }
 
 bool GenericEnginePlatform::registerSignal(QObject *item, const QString &signalName)
@@ -1133,8 +1344,14 @@ void GenericEnginePlatform::execute(ITransportClient* socket,
                                     const QString& methodName,
                                     const QVariantList& params)
 {
+    static const QAStats::Key unknownKey = QAStats::key(QStringLiteral("executeCommand_unknown"));
+    QAStats::Timer timer(unknownKey);
     bool handled = false;
     bool success = QAEngine::metaInvoke(socket, this, methodName, params, &handled);
+    if (handled)
+    {
+        timer.setKey(methodName);
+    }
 
     if (!handled || !success)
     {
@@ -1143,33 +1360,27 @@ void GenericEnginePlatform::execute(ITransportClient* socket,
     }
 }
 
-void GenericEnginePlatform::onPropertyChanged()
+bool GenericEnginePlatform::executeRegistered(ITransportClient* socket,
+                                              const QString& command,
+                                              const QVariantList& params)
 {
-    QObject* item = sender();
-    QEventLoop* loop = item->property("WaitForPropertyChangeEventLoop").value<QEventLoop*>();
-    if (!loop)
-    {
-        return;
-    }
-    const QString propertyName = item->property("WaitForPropertyChangePropertyName").toString();
-    const QVariant propertyValue = item->property("WaitForPropertyChangePropertyValue");
-    if (!propertyValue.isValid())
+    const QAEngine::CommandHandler handler = QAEngine::registeredCommand(command);
+    if (!handler)
     {
-        loop->quit();
-        return;
-    }
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    if (propertyValue.canConvert<std::nullptr_t>())
-    {
-        loop->quit();
-        return;
+        return false;
     }
-#endif
-    const QVariant property = item->property(propertyName.toLatin1().constData());
-    if (property == propertyValue)
+
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << command;
+
+    QAStats::Timer timer(command);
+    const QVariant result = handler(*QASession::forClient(socket), params);
+    if (QAPendingEvent* pending = qobject_cast<QAPendingEvent*>(result.value<QObject*>()))
     {
-        loop->quit();
+        pendingReply(socket, pending);
+        return true;
     }
+    socketReply(socket, result.isValid() ? result : QVariant(QString()));
+    return true;
 }
 
 void GenericEnginePlatform::onSignalReceived()
@@ -1184,56 +1395,83 @@ void GenericEnginePlatform::onSignalReceived()
 
     QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalSig);
 
-    if (m_signalCounter.contains(key)) {
-        m_signalCounter[key] += 1;
-        qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << "signal counter:" << m_signalCounter[key];
-    } else {
-        qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << "signal not registered";
+    for (QASession* session : QASession::sessions())
+    {
+        session->countSignal(key);
     }
 }
 
-void GenericEnginePlatform::analyzePressed(const QPoint &point)
+bool GenericEnginePlatform::isSignalRegistered(const QString& key)
 {
-    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << point;
+    for (QASession* session : QASession::sessions())
+    {
+        if (session->hasSignal(key))
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    if (!m_analyzeSocket)
-        return;
+void GenericEnginePlatform::sessionClosed(QASession* session)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << session;
 
-    m_analyzeSocket->write(QStringLiteral("pressed: %1,%2\n").arg(point.x()).arg(point.y()).toLatin1());
-    m_analyzeSocket->flush();
+    stopAnalyze(session->client());
 
-    const auto reply = recursiveDumpTree(m_rootWindow, m_lastFilters);
-    const auto json = QJsonDocument(reply).toJson(QJsonDocument::Compact);
-    const auto jsonCompress = qCompress(json, 9);
-    m_analyzeSocket->write("dump start: ");
-    m_analyzeSocket->write(QByteArray::number(jsonCompress.size()));
-    m_analyzeSocket->write("\n");
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+    const auto registrations = session->signalRegistrations();
+    for (auto it = registrations.constBegin(); it != registrations.constEnd(); ++it)
+    {
+        session->unregisterSignal(it.key());
+        // connection is shared, keep it while other sessions count this signal
+        if (it->item && !isSignalRegistered(it.key()))
+        {
+            unregisterSignal(it->item, it->signalName);
+        }
+    }
+}
+
+void GenericEnginePlatform::analyzePressed(const QPoint &point)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << point;
 
-    m_analyzeSocket->write(jsonCompress);
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+    // screenshot is shared, dump depends on filters of each session
+    QByteArray screenCompress;
+    for (ITransportClient* client : m_analyzeClients)
+    {
+        // negotiated framing and compression apply to analyze messages too
+        client->postFrame(
+            QStringLiteral("pressed: %1,%2\n").arg(point.x()).arg(point.y()).toLatin1());
 
-    m_analyzeSocket->write("\ndump end\n");
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+        if (client->isBackpressured())
+        {
+            // reader is behind, do not even grab a frame it would receive stale
+            qCDebug(categoryGenericEnginePlatform)
+                << Q_FUNC_INFO << client << "dropping dump, pending:" << client->pendingBytes();
+            continue;
+        }
 
-    const auto screen = grabDirectScreenshot();
-    const auto screenCompress = qCompress(screen, 9);
-    m_analyzeSocket->write("screen start: ");
-    m_analyzeSocket->write(QByteArray::number(screenCompress.size()));
-    m_analyzeSocket->write("\n");
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+        const QVariantList filters = QASession::forClient(client)->lastFilters();
+        const auto reply = recursiveDumpTree(m_rootWindow, filters);
+        const auto json = QJsonDocument(reply).toJson(QJsonDocument::Compact);
+        const auto jsonCompress = qCompress(json, QACompressor::payloadLevel());
+        if (screenCompress.isEmpty())
+        {
+            screenCompress = qCompress(grabDirectScreenshot(), QACompressor::payloadLevel());
+        }
 
-    m_analyzeSocket->write(screenCompress);
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+        QByteArray frame;
+        frame.reserve(jsonCompress.size() + screenCompress.size() + 128);
+        frame += "dump start: " + QByteArray::number(jsonCompress.size()) + "\n";
+        frame += jsonCompress;
+        frame += "\ndump end\n";
+        frame += "screen start: " + QByteArray::number(screenCompress.size()) + "\n";
+        frame += screenCompress;
+        frame += "\nscreen end\n";
 
-    m_analyzeSocket->write("\nscreen end\n");
-    m_analyzeSocket->flush();
-    m_analyzeSocket->waitForBytesWritten();
+        // a newer dump replaces one still waiting in output queue
+        client->postFrame(frame, QStringLiteral("analyze"));
+    }
 }
 
 void GenericEnginePlatform::onTouchEvent(const QTouchEvent& event)
@@ -1309,7 +1547,16 @@ void GenericEnginePlatform::onWheelEvent(const QWheelEvent &event)
 void GenericEnginePlatform::appConnectCommand(ITransportClient* socket)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
-    socketReply(socket, QString());
+
+    const QVariantMap options = socket->connectionOptions();
+    if (options.isEmpty())
+    {
+        socketReply(socket, QString());
+    }
+    else
+    {
+        socketReply(socket, options);
+    }
 }
 
 void GenericEnginePlatform::appDisconnectCommand(ITransportClient* socket)
@@ -1404,23 +1651,21 @@ void GenericEnginePlatform::backgroundCommand(ITransportClient* socket, qlonglon
     if (!m_rootWindow)
     {
         qCWarning(categoryGenericEnginePlatform) << Q_FUNC_INFO << "No window!";
+        socketReply(socket, QStringLiteral("No window"), 1);
         return;
     }
 
     m_rootWindow->showMinimized();
     m_rootWindow->lower();
-    if (seconds > 0)
+    if (seconds <= 0)
     {
-        QEventLoop loop;
-        QTimer timer;
-        timer.setSingleShot(true);
-        connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-        timer.start(seconds * 1000);
-        loop.exec();
-        activateWindow();
+        socketReply(socket, QString());
+        return;
     }
 
-    socketReply(socket, QString());
+    QAPendingEvent* pending = delayedEvent(seconds * 1000);
+    connect(pending, &QAPendingEvent::completed, this, &GenericEnginePlatform::activateWindow);
+    pendingReply(socket, pending);
 }
 
 void GenericEnginePlatform::getClipboardCommand(ITransportClient* socket)
@@ -1747,8 +1992,7 @@ void GenericEnginePlatform::clickCommand(ITransportClient* socket, const QString
     QObject* item = getObject(elementId);
     if (item)
     {
-        clickItem(item);
-        socketReply(socket, QString());
+        pendingReply(socket, clickItem(item));
     }
     else
     {
@@ -1767,14 +2011,21 @@ void GenericEnginePlatform::submitCommand(ITransportClient* socket, const QStrin
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << elementId;
 
-    m_keyMouseEngine->pressEnter();
-    socketReply(socket, QString());
+    pendingReply(socket, m_keyMouseEngine->pressEnter());
 }
 
 void GenericEnginePlatform::getPageSourceCommand(ITransportClient* socket)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
 
+    if (socket->isStreaming())
+    {
+        QASession::forClient(socket)->deferReply();
+        streamDumpXml(
+            new QAReplyStream(socket, socket->requestId(), QAReplyStream::StringValue, this));
+        return;
+    }
+
     QString out;
     QXmlStreamWriter writer(&out);
     writer.setAutoFormatting(false);
@@ -1919,6 +2170,11 @@ void GenericEnginePlatform::executeCommand(ITransportClient* socket,
 {
     qWarning() << Q_FUNC_INFO << socket << command << params;
 
+    if (executeRegistered(socket, command, params))
+    {
+        return;
+    }
+
     QString executeCommand;
 
     if (command.startsWith("/* submitForm */")) {
@@ -1940,6 +2196,11 @@ void GenericEnginePlatform::executeAsyncCommand(ITransportClient* socket,
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << command << params;
 
+    if (executeRegistered(socket, command, params))
+    {
+        return;
+    }
+
     const QString fixCommand = QString(command)
                                        .replace("mobile: ", "")
                                        .replace(": ", "_")
@@ -1953,14 +2214,7 @@ void GenericEnginePlatform::performTouchCommand(ITransportClient* socket, const
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << paramsArg;
 
-    QEventLoop loop;
-    connect(m_keyMouseEngine->performTouchAction(paramsArg.toList()),
-            &QAPendingEvent::completed,
-            &loop,
-            &QEventLoop::quit);
-    loop.exec();
-
-    socketReply(socket, QString());
+    pendingReply(socket, m_keyMouseEngine->performTouchAction(paramsArg.toList()));
 }
 
 void GenericEnginePlatform::performMultiActionCommand(ITransportClient* socket,
@@ -1968,14 +2222,7 @@ void GenericEnginePlatform::performMultiActionCommand(ITransportClient* socket,
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << paramsArg;
 
-    QEventLoop loop;
-    connect(m_keyMouseEngine->performMultiAction(paramsArg.toList()),
-            &QAPendingEvent::completed,
-            &loop,
-            &QEventLoop::quit);
-    loop.exec();
-
-    socketReply(socket, QString());
+    pendingReply(socket, m_keyMouseEngine->performMultiAction(paramsArg.toList()));
 }
 
 void GenericEnginePlatform::performActionsCommand(ITransportClient* socket,
@@ -1990,14 +2237,7 @@ void GenericEnginePlatform::performActionsCommand(ITransportClient* socket,
         return;
     }
 
-    QEventLoop loop;
-    connect(m_keyMouseEngine->performChainActions(params),
-            &QAPendingEvent::completed,
-            &loop,
-            &QEventLoop::quit);
-    loop.exec();
-
-    socketReply(socket, QString());
+    pendingReply(socket, m_keyMouseEngine->performChainActions(params));
 }
 
 void GenericEnginePlatform::getTimeoutsCommand(ITransportClient* socket)
@@ -2022,7 +2262,7 @@ void GenericEnginePlatform::stopAnalyzeCommand(ITransportClient *socket)
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
 
-    stopAnalyze();
+    stopAnalyze(socket);
 }
 
 void GenericEnginePlatform::findStrategy_id(ITransportClient* socket,
@@ -2184,11 +2424,23 @@ void GenericEnginePlatform::executeCommand_app_dumpTreeFilter(ITransportClient*
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << filters;
 
-    m_lastFilters = filters;
+    QASession::forClient(socket)->setLastFilters(filters);
+
+    if (socket->isStreaming())
+    {
+        // plain tree object, compressing would need the whole document
+        QASession::forClient(socket)->deferReply();
+        streamDumpTree(
+            new QAReplyStream(socket, socket->requestId(), QAReplyStream::JsonValue, this),
+            filters);
+        return;
+    }
 
     QJsonObject reply = recursiveDumpTree(m_rootWindow, filters);
     socketReply(socket,
-                qCompress(QJsonDocument(reply).toJson(QJsonDocument::Compact), 9).toBase64());
+                socket->payloadValue(
+                    qCompress(QJsonDocument(reply).toJson(QJsonDocument::Compact),
+                              QACompressor::payloadLevel())));
 }
 
 void GenericEnginePlatform::executeCommand_app_setAttribute(ITransportClient* socket,
@@ -2214,8 +2466,7 @@ void GenericEnginePlatform::executeCommand_app_waitForPropertyChange(ITransportC
     QObject* item = getObject(elementId);
     if (item)
     {
-        bool result = waitForPropertyChange(item, propertyName, value, timeout);
-        socketReply(socket, result);
+        pendingReply(socket, waitForPropertyChange(item, propertyName, value, timeout));
     }
     else
     {
@@ -2228,8 +2479,7 @@ void GenericEnginePlatform::executeCommand_app_waitForWindowChange(ITransportCli
 {
     qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << timeout;
 
-    bool result = waitForWindowChange(timeout);
-    socketReply(socket, result);
+    pendingReply(socket, waitForWindowChange(timeout));
 }
 
 void GenericEnginePlatform::executeCommand_app_registerSignal(ITransportClient *socket, const QString &elementId, const QString &signalName)
@@ -2240,10 +2490,11 @@ void GenericEnginePlatform::executeCommand_app_registerSignal(ITransportClient *
         return;
     }
 
-    int ret = registerSignal(item, signalName) ? 0 : 1;
+    // one connection serves every session counting this signal
+    QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalName);
+    int ret = isSignalRegistered(key) || registerSignal(item, signalName) ? 0 : 1;
     if (ret == 0) {
-        QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalName);
-        m_signalCounter[key] = 0;
+        QASession::forClient(socket)->registerSignal(key, item, signalName);
     }
 
     socketReply(socket, QString(), ret);
@@ -2257,11 +2508,9 @@ void GenericEnginePlatform::executeCommand_app_unregisterSignal(ITransportClient
         return;
     }
 
-    int ret = unregisterSignal(item, signalName) ? 0 : 1;
-    if (ret == 0) {
-        QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalName);
-        m_signalCounter.remove(key);
-    }
+    QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalName);
+    QASession::forClient(socket)->unregisterSignal(key);
+    int ret = isSignalRegistered(key) || unregisterSignal(item, signalName) ? 0 : 1;
 
     socketReply(socket, QString(), ret);
 }
@@ -2274,16 +2523,57 @@ void GenericEnginePlatform::executeCommand_app_countSignals(ITransportClient *so
         return;
     }
 
-    int count = -1;
-
     QString key = QStringLiteral("%1_%2").arg(uniqueId(item)).arg(signalName);
-    if (m_signalCounter.contains(key)) {
-        count = m_signalCounter[key];
-    }
+    int count = QASession::forClient(socket)->signalCount(key);
 
     socketReply(socket, count);
 }
 
+void GenericEnginePlatform::executeCommand_app_stats(ITransportClient* socket)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
+
+    socketReply(socket, QAStats::summary());
+}
+
+void GenericEnginePlatform::executeCommand_app_resetStats(ITransportClient* socket)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
+
+    QAStats::reset();
+    socketReply(socket, QString());
+}
+
+void GenericEnginePlatform::executeCommand_app_startTrace(ITransportClient* socket)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket;
+
+    QATrace::start();
+    socketReply(socket, QString());
+}
+
+void GenericEnginePlatform::executeCommand_app_stopTrace(ITransportClient* socket)
+{
+    executeCommand_app_stopTrace(
+        socket,
+        QDir::temp().filePath(
+            QStringLiteral("qaengine-trace-%1.json").arg(QCoreApplication::applicationPid())));
+}
+
+void GenericEnginePlatform::executeCommand_app_stopTrace(ITransportClient* socket,
+                                                         const QString& filePath)
+{
+    qCDebug(categoryGenericEnginePlatform) << Q_FUNC_INFO << socket << filePath;
+
+    QATrace::stop();
+    if (!QATrace::save(filePath))
+    {
+        socketReply(socket, QStringLiteral("Can't write %1").arg(filePath), 1);
+        return;
+    }
+    socketReply(socket, filePath);
+}
+
 void GenericEnginePlatform::executeCommand_app_setLoggingFilter(ITransportClient* socket,
                                                                 const QString& rules)
 {
@@ -2359,14 +2649,12 @@ void GenericEnginePlatform::executeCommand_app_installFileLogger(ITransportClien
 
 void GenericEnginePlatform::executeCommand_app_click(ITransportClient *socket, double mousex, double mousey)
 {
-    clickPoint(mousex, mousey);
-    socketReply(socket, QString());
+    pendingReply(socket, clickPoint(mousex, mousey));
 }
 
 void GenericEnginePlatform::executeCommand_app_click(ITransportClient *socket, qlonglong mousex, qlonglong mousey)
 {
-    clickPoint(mousex, mousey);
-    socketReply(socket, QString());
+    pendingReply(socket, clickPoint(mousex, mousey));
 }
 
 void GenericEnginePlatform::executeCommand_app_exit(ITransportClient* socket, double code)
@@ -2385,26 +2673,22 @@ void GenericEnginePlatform::executeCommand_app_crash(ITransportClient *socket)
 
 void GenericEnginePlatform::executeCommand_app_pressAndHold(ITransportClient *socket, double mousex, double mousey)
 {
-    pressAndHold(mousex, mousey, 1500);
-    socketReply(socket, QString());
+    pendingReply(socket, pressAndHold(mousex, mousey, 1500));
 }
 
 void GenericEnginePlatform::executeCommand_app_pressAndHold(ITransportClient *socket, qlonglong mousex, qlonglong mousey)
 {
-    pressAndHold(mousex, mousey, 1500);
-    socketReply(socket, QString());
+    pendingReply(socket, pressAndHold(mousex, mousey, 1500));
 }
 
 void GenericEnginePlatform::executeCommand_app_move(ITransportClient *socket, double fromx, double fromy, double tox, double toy)
 {
-    mouseMove(fromx, fromy, tox, toy);
-    socketReply(socket, QString());
+    pendingReply(socket, mouseMove(fromx, fromy, tox, toy));
 }
 
 void GenericEnginePlatform::executeCommand_app_move(ITransportClient *socket, qlonglong fromx, qlonglong fromy, qlonglong tox, qlonglong toy)
 {
-    mouseMove(fromx, fromy, tox, toy);
-    socketReply(socket, QString());
+    pendingReply(socket, mouseMove(fromx, fromy, tox, toy));
 }
 
 void GenericEnginePlatform::executeCommand_app_listSignals(ITransportClient *socket, const QString &elementId)
@@ -2437,6 +2721,63 @@ void GenericEnginePlatform::executeCommand_app_listSignals(ITransportClient *soc
     socketReply(socket, result);
 }
 
+PropertyChangeWaiter::PropertyChangeWaiter(QObject* item,
+                                           const QMetaProperty& property,
+                                           const QVariant& value,
+                                           int timeout,
+                                           QObject* parent)
+    : QAPendingEvent(parent)
+    , m_item(item)
+    , m_property(property)
+    , m_value(value)
+{
+    const QMetaMethod propertyChanged =
+        metaObject()->method(metaObject()->indexOfSlot("onPropertyChanged()"));
+    connect(item, m_property.notifySignal(), this, propertyChanged);
+    connect(item, &QObject::destroyed, this, &PropertyChangeWaiter::onTimeout);
+    connect(&m_timer, &QTimer::timeout, this, &PropertyChangeWaiter::onTimeout);
+    connect(this, &QAPendingEvent::completed, this, &QObject::deleteLater);
+
+    m_timer.setSingleShot(true);
+    m_timer.start(timeout);
+}
+
+void PropertyChangeWaiter::onPropertyChanged()
+{
+    if (!m_value.isValid())
+    {
+        finish(true);
+        return;
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    if (m_value.canConvert<std::nullptr_t>())
+    {
+        finish(true);
+        return;
+    }
+#endif
+    if (m_item && m_property.read(m_item) == m_value)
+    {
+        finish(true);
+    }
+}
+
+void PropertyChangeWaiter::onTimeout()
+{
+    finish(false);
+}
+
+void PropertyChangeWaiter::finish(bool result)
+{
+    m_timer.stop();
+    if (m_item)
+    {
+        m_item->disconnect(this);
+    }
+    setResult(result);
+    setCompleted();
+}
+
 AnalyzeEventFilter::AnalyzeEventFilter(QObject *parent)
     : QObject(parent)
 {
@@ -1,6 +1,652 @@
 #include <qt_qa_engine/ITransportClient.h>
+#include <qt_qa_engine/QACompressor.h>
+#include <qt_qa_engine/QASharedMemoryChannel.h>
+#include <qt_qa_engine/QAStats.h>
+
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QThread>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QCborStreamWriter>
+#include <QCborValue>
+#endif
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryITransportClient, "autoqa.qaengine.transport.client", QtWarningMsg)
+
+namespace
+{
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+void writeCbor(QCborStreamWriter& writer, const QVariant& value)
+{
+    switch (value.userType())
+    {
+        case QMetaType::UnknownType:
+        case QMetaType::Nullptr:
+            writer.append(nullptr);
+            break;
+        case QMetaType::Bool:
+            writer.append(value.toBool());
+            break;
+        case QMetaType::Int:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+        case QMetaType::Short:
+            writer.append(value.toLongLong());
+            break;
+        case QMetaType::UInt:
+        case QMetaType::ULong:
+        case QMetaType::ULongLong:
+        case QMetaType::UShort:
+            writer.append(value.toULongLong());
+            break;
+        case QMetaType::Float:
+        case QMetaType::Double:
+            writer.append(value.toDouble());
+            break;
+        case QMetaType::QByteArray:
+            // native byte string, no base64
+            writer.append(value.toByteArray());
+            break;
+        case QMetaType::QString:
+            writer.append(value.toString());
+            break;
+        case QMetaType::QVariantList:
+        case QMetaType::QStringList:
+        {
+            const QVariantList list = value.toList();
+            writer.startArray(quint64(list.size()));
+            for (const QVariant& item : list)
+            {
+                writeCbor(writer, item);
+            }
+            writer.endArray();
+            break;
+        }
+        case QMetaType::QVariantMap:
+        {
+            const QVariantMap map = value.toMap();
+            writer.startMap(quint64(map.size()));
+            for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+            {
+                writer.append(it.key());
+                writeCbor(writer, it.value());
+            }
+            writer.endMap();
+            break;
+        }
+        case QMetaType::QVariantHash:
+        {
+            const QVariantHash hash = value.toHash();
+            writer.startMap(quint64(hash.size()));
+            for (auto it = hash.constBegin(); it != hash.constEnd(); ++it)
+            {
+                writer.append(it.key());
+                writeCbor(writer, it.value());
+            }
+            writer.endMap();
+            break;
+        }
+        case QMetaType::QJsonValue:
+            QCborValue::fromJsonValue(value.toJsonValue()).toCbor(writer);
+            break;
+        case QMetaType::QJsonObject:
+            QCborValue::fromJsonValue(value.toJsonObject()).toCbor(writer);
+            break;
+        case QMetaType::QJsonArray:
+            QCborValue::fromJsonValue(value.toJsonArray()).toCbor(writer);
+            break;
+        default:
+            QCborValue::fromVariant(value).toCbor(writer);
+            break;
+    }
+}
+#endif
+
+} // namespace
 
 ITransportClient::ITransportClient(QObject* parent)
     : QObject(parent)
+    , m_pendingBytes(0)
+    , m_highWaterMark(s_defaultHighWaterMark)
+    , m_lowWaterMark(s_defaultLowWaterMark)
+    , m_backpressured(0)
+    , m_streaming(0)
+{
+    connect(this, &ITransportClient::bytesWritten, this, &ITransportClient::onBytesWritten);
+    connect(this, &ITransportClient::disconnected, this, &ITransportClient::dropQueue);
+}
+
+ITransportClient::~ITransportClient()
+{
+}
+
+QAFrameDecoder* ITransportClient::decoder()
+{
+    return &m_decoder;
+}
+
+QAFrameDecoder::Mode ITransportClient::framingMode() const
+{
+    return m_decoder.mode();
+}
+
+void ITransportClient::setFramingMode(QAFrameDecoder::Mode mode)
+{
+    m_decoder.setMode(mode);
+}
+
+qint64 ITransportClient::writeFrame(const QByteArray& data)
+{
+    const QByteArray frame = encodeFrame(data);
+    enqueue(frame);
+    return frame.size();
+}
+
+QByteArray ITransportClient::encodeFrame(const QByteArray& data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray compressed;
+    const bool compress = m_compressor && m_decoder.mode() == QAFrameDecoder::LengthPrefixedMode
+                          && data.size() >= m_compressor->threshold()
+                          && m_compressor->compress(data, &compressed);
+
+    const QByteArray frame =
+        QAFrameDecoder::encodeFrame(compress ? compressed : data, m_decoder.mode(), compress);
+    if (compress)
+    {
+        static const QAStats::Key compressKey = QAStats::key(QStringLiteral("reply:compress"));
+        QAStats::record(compressKey, timer.nsecsElapsed());
+    }
+    return frame;
+}
+
+void ITransportClient::sendReply(const QVariant& requestId, const QVariant& value, int status)
+{
+    emit replySent(this, requestId);
+
+    if (thread() != QThread::currentThread())
+    {
+        QMetaObject::invokeMethod(this,
+                                  "writeReply",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QVariant, requestId),
+                                  Q_ARG(QVariant, value),
+                                  Q_ARG(int, status));
+        return;
+    }
+    writeReply(requestId, value, status);
+}
+
+void ITransportClient::post(const QByteArray& data, const QString& tag)
+{
+    if (thread() != QThread::currentThread())
+    {
+        // counted right away, so producers see data waiting in the event queue too
+        updatePendingBytes(data.size());
+        QMetaObject::invokeMethod(this,
+                                  "enqueuePosted",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, data),
+                                  Q_ARG(QString, tag));
+        return;
+    }
+    enqueue(data, tag);
+}
+
+void ITransportClient::postFrame(const QByteArray& data, const QString& tag)
+{
+    // counted right away like post(), replaced by the frame size once encoded
+    updatePendingBytes(data.size());
+    if (thread() != QThread::currentThread())
+    {
+        QMetaObject::invokeMethod(this,
+                                  "enqueuePostedFrame",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, data),
+                                  Q_ARG(QString, tag));
+        return;
+    }
+    enqueuePostedFrame(data, tag);
+}
+
+void ITransportClient::postStreamChunk(const QByteArray& data, bool last)
+{
+    updatePendingBytes(data.size());
+    if (thread() != QThread::currentThread())
+    {
+        QMetaObject::invokeMethod(this,
+                                  "enqueueStreamChunk",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, data),
+                                  Q_ARG(bool, last));
+        return;
+    }
+    enqueueStreamChunk(data, last);
+}
+
+qint64 ITransportClient::pendingBytes() const
+{
+    return m_pendingBytes.loadAcquire();
+}
+
+bool ITransportClient::isBackpressured() const
+{
+    return m_backpressured.loadAcquire();
+}
+
+void ITransportClient::setWaterMarks(qint64 low, qint64 high)
+{
+    m_lowWaterMark.storeRelease(qMin(low, high));
+    m_highWaterMark.storeRelease(high);
+}
+
+void ITransportClient::writeReply(const QVariant& requestId, const QVariant& value, int status)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray data;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    if (m_encoding == CborEncoding)
+    {
+        QCborStreamWriter writer(&data);
+        writer.startMap(requestId.isValid() ? 3 : 2);
+        if (requestId.isValid())
+        {
+            writer.append(QLatin1String("id"));
+            writeCbor(writer, requestId);
+        }
+        writer.append(QLatin1String("status"));
+        writer.append(qint64(status));
+        writer.append(QLatin1String("value"));
+        writeCbor(writer, value);
+        writer.endMap();
+    }
+    else
+#endif
+    {
+        QJsonObject reply;
+        if (requestId.isValid())
+        {
+            reply.insert(QStringLiteral("id"), QJsonValue::fromVariant(requestId));
+        }
+        reply.insert(QStringLiteral("status"), status);
+        reply.insert(QStringLiteral("value"), QJsonValue::fromVariant(value));
+
+        data = QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    }
+    static const QAStats::Key encodeKey = QAStats::key(QStringLiteral("reply:encode"));
+    QAStats::record(encodeKey, timer.nsecsElapsed());
+
+    const qint64 written = writeFrame(data);
+    qCDebug(categoryITransportClient) << Q_FUNC_INFO << this << requestId << written;
+}
+
+void ITransportClient::enqueue(const QByteArray& data, const QString& tag)
+{
+    updatePendingBytes(data.size());
+    appendToQueue(data, tag);
+}
+
+void ITransportClient::enqueuePosted(const QByteArray& data, const QString& tag)
+{
+    appendToQueue(data, tag);
+}
+
+void ITransportClient::enqueuePostedFrame(const QByteArray& data, const QString& tag)
+{
+    updatePendingBytes(-data.size());
+    enqueue(encodeFrame(data), tag);
+}
+
+void ITransportClient::enqueueStreamChunk(const QByteArray& data, bool last)
+{
+    PendingWrite pending;
+    pending.data = data;
+    m_outQueue.append(pending);
+    m_streamOpen = !last;
+
+    if (last)
+    {
+        qCDebug(categoryITransportClient)
+            << Q_FUNC_INFO << this << "releasing held data:" << m_heldQueue.size();
+        const QList<PendingWrite> held = m_heldQueue;
+        m_heldQueue.clear();
+        for (const PendingWrite& write : held)
+        {
+            enqueue(write.data, write.tag);
+        }
+    }
+    drain();
+}
+
+void ITransportClient::appendToQueue(const QByteArray& data, const QString& tag)
+{
+    // held data does not count as pending, or it would keep the stream paused for good
+    if (m_streamOpen)
+    {
+        updatePendingBytes(-data.size());
+    }
+    QList<PendingWrite>& queue = m_streamOpen ? m_heldQueue : m_outQueue;
+
+    if (!tag.isEmpty())
+    {
+        for (int i = 0; i < queue.size(); i++)
+        {
+            // partially written data has to be finished, the peer already has its beginning
+            if (queue.at(i).tag == tag && queue.at(i).offset == 0)
+            {
+                qCDebug(categoryITransportClient)
+                    << Q_FUNC_INFO << this << "coalescing stale" << tag << queue.at(i).data.size();
+                if (!m_streamOpen)
+                {
+                    updatePendingBytes(-queue.at(i).data.size());
+                }
+                queue.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    PendingWrite pending;
+    pending.data = data;
+    pending.tag = tag;
+    queue.append(pending);
+
+    drain();
+}
+
+void ITransportClient::drain()
+{
+    if (m_draining)
+    {
+        return;
+    }
+    m_draining = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool written = false;
+    while (!m_outQueue.isEmpty() && bytesToWrite() < s_socketChunk)
+    {
+        PendingWrite& pending = m_outQueue.first();
+        const int size = qMin(pending.data.size() - pending.offset, int(s_socketChunk));
+        // socket copies the data, so the portion needs no copy of its own
+        const QByteArray portion =
+            pending.offset == 0 && size == pending.data.size()
+                ? pending.data
+                : QByteArray::fromRawData(pending.data.constData() + pending.offset, size);
+        if (write(portion) < 0)
+        {
+            qCWarning(categoryITransportClient) << Q_FUNC_INFO << this << "write failed";
+            updatePendingBytes(-(pending.data.size() - pending.offset));
+            m_outQueue.removeFirst();
+            continue;
+        }
+        m_socketBytes += size;
+        written = true;
+
+        pending.offset += size;
+        if (pending.offset == pending.data.size())
+        {
+            m_outQueue.removeFirst();
+        }
+    }
+    if (written)
+    {
+        flush();
+        static const QAStats::Key writeKey = QAStats::key(QStringLiteral("socket:write"));
+        QAStats::record(writeKey, timer.nsecsElapsed());
+    }
+
+    m_draining = false;
+}
+
+void ITransportClient::onBytesWritten(ITransportClient*, qint64 bytes)
+{
+    // direct write() calls bypass the queue and are not accounted
+    const qint64 queued = qMin(bytes, m_socketBytes);
+    m_socketBytes -= queued;
+    updatePendingBytes(-queued);
+    drain();
+}
+
+void ITransportClient::dropQueue()
+{
+    // data posted but not queued yet stays pending until it is queued and written
+    qint64 dropped = m_socketBytes;
+    for (const PendingWrite& pending : m_outQueue)
+    {
+        dropped += pending.data.size() - pending.offset;
+    }
+    m_outQueue.clear();
+    m_heldQueue.clear();
+    m_streamOpen = false;
+    m_socketBytes = 0;
+    updatePendingBytes(-dropped);
+}
+
+void ITransportClient::updatePendingBytes(qint64 delta)
+{
+    const qint64 pending = m_pendingBytes.fetchAndAddOrdered(delta) + delta;
+
+    if (!m_backpressured.loadAcquire() && pending >= m_highWaterMark.loadAcquire())
+    {
+        qCDebug(categoryITransportClient) << Q_FUNC_INFO << this << "high water mark:" << pending;
+        m_backpressured.storeRelease(1);
+        emit highWaterMarkReached(this);
+    }
+    else if (m_backpressured.loadAcquire() && pending <= m_lowWaterMark.loadAcquire())
+    {
+        qCDebug(categoryITransportClient) << Q_FUNC_INFO << this << "low water mark:" << pending;
+        m_backpressured.storeRelease(0);
+        emit lowWaterMarkReached(this);
+    }
+}
+
+QVariant ITransportClient::payloadValue(const QByteArray& payload)
+{
+    if (m_sharedMemory)
+    {
+        const QVariant handle = m_sharedMemory->write(payload);
+        if (handle.isValid())
+        {
+            return handle;
+        }
+        qCDebug(categoryITransportClient)
+            << Q_FUNC_INFO << "payload does not fit shared memory:" << payload.size();
+    }
+    if (m_negotiatedEncoding == CborEncoding)
+    {
+        return payload;
+    }
+    return QString::fromLatin1(payload.toBase64());
+}
+
+ITransportClient* ITransportClient::sessionClient()
+{
+    return this;
+}
+
+QVariant ITransportClient::requestId() const
+{
+    return m_requestIds.isEmpty() ? QVariant() : m_requestIds.last();
+}
+
+QVariant ITransportClient::sessionRequestId() const
+{
+    return requestId();
+}
+
+void ITransportClient::beginRequest(const QVariant& requestId)
+{
+    m_requestIds.append(requestId);
+}
+
+void ITransportClient::endRequest()
+{
+    if (!m_requestIds.isEmpty())
+    {
+        m_requestIds.removeLast();
+    }
+}
+
+QVariantMap ITransportClient::negotiate(const QVariantMap& requested)
+{
+    qCDebug(categoryITransportClient) << Q_FUNC_INFO << this << requested;
+
+    m_connectionOptions.clear();
+
+    const QString framing = requested.value(QStringLiteral("framing")).toString();
+    if (framing == QLatin1String("length-prefixed"))
+    {
+        m_negotiatedFraming = QAFrameDecoder::LengthPrefixedMode;
+        m_connectionOptions.insert(QStringLiteral("framing"), framing);
+    }
+    else if (!framing.isEmpty())
+    {
+        m_negotiatedFraming = QAFrameDecoder::JsonMode;
+        m_connectionOptions.insert(QStringLiteral("framing"), QStringLiteral("json"));
+    }
+
+    const QVariant sharedMemory = requested.value(QStringLiteral("sharedMemory"));
+    int sharedMemorySize = sharedMemory.userType() == QMetaType::Bool
+                               ? (sharedMemory.toBool() ? int(QASharedMemoryChannel::s_defaultSize) : 0)
+                               : sharedMemory.toInt();
+    sharedMemorySize = qBound(0, sharedMemorySize, int(QASharedMemoryChannel::s_maxSize));
+    if (sharedMemorySize == 0)
+    {
+        m_sharedMemory.reset();
+    }
+    else
+    {
+        if (!m_sharedMemory || m_sharedMemory->size() < sharedMemorySize)
+        {
+            m_sharedMemory.reset(new QASharedMemoryChannel(sharedMemorySize));
+        }
+        if (m_sharedMemory->isValid())
+        {
+            m_connectionOptions.insert(QStringLiteral("sharedMemory"), m_sharedMemory->description());
+        }
+        else
+        {
+            m_sharedMemory.reset();
+        }
+    }
+
+    // CBOR replies are not self-delimiting for JSON scanner, so it needs length-prefixed framing
+    const QString encoding = requested.value(QStringLiteral("encoding")).toString();
+    if (!encoding.isEmpty())
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+        const bool cbor = encoding == QLatin1String("cbor")
+                          && m_negotiatedFraming == QAFrameDecoder::LengthPrefixedMode;
+#else
+        const bool cbor = false;
+#endif
+        m_negotiatedEncoding = cbor ? CborEncoding : JsonEncoding;
+        m_connectionOptions.insert(QStringLiteral("encoding"),
+                                   cbor ? QStringLiteral("cbor") : QStringLiteral("json"));
+    }
+
+    // compression flag lives in length header, so it needs length-prefixed framing
+    m_negotiatedCompressor.reset();
+    // single method name or list in order of preference
+    const QStringList compression = requested.value(QStringLiteral("compression")).toStringList();
+    if (m_negotiatedFraming == QAFrameDecoder::LengthPrefixedMode)
+    {
+        for (const QString& name : compression)
+        {
+            const QACompressor::Method method = QACompressor::methodFromName(name);
+            if (method == QACompressor::NoCompression)
+            {
+                continue;
+            }
+            m_negotiatedCompressor.reset(new QACompressor(
+                method,
+                requested.value(QStringLiteral("compressionLevel"), -1).toInt(),
+                requested
+                    .value(QStringLiteral("compressionThreshold"),
+                           int(QACompressor::s_defaultThreshold))
+                    .toInt()));
+            if (!m_negotiatedCompressor->isValid())
+            {
+                m_negotiatedCompressor.reset();
+                continue;
+            }
+            m_connectionOptions.insert(QStringLiteral("compression"), name);
+            m_connectionOptions.insert(QStringLiteral("compressionLevel"),
+                                       m_negotiatedCompressor->level());
+            m_connectionOptions.insert(QStringLiteral("compressionThreshold"),
+                                       m_negotiatedCompressor->threshold());
+            break;
+        }
+    }
+
+    // streamed reply is written as it is produced, so its length and encoding are not known ahead
+    const QVariant streaming = requested.value(QStringLiteral("streaming"));
+    if (streaming.isValid())
+    {
+        m_negotiatedStreaming = streaming.toBool()
+                                && m_negotiatedFraming == QAFrameDecoder::JsonMode
+                                && m_negotiatedEncoding == JsonEncoding;
+        m_connectionOptions.insert(QStringLiteral("streaming"), m_negotiatedStreaming);
+    }
+
+    return m_connectionOptions;
+}
+
+void ITransportClient::applyNegotiated()
+{
+    if (thread() != QThread::currentThread())
+    {
+        // queued behind appConnect reply
+        QMetaObject::invokeMethod(this, "applyNegotiated", Qt::QueuedConnection);
+        return;
+    }
+    // called after appConnect reply is written, so it still goes out with previous framing
+    setFramingMode(m_negotiatedFraming);
+    m_compressor.reset(m_negotiatedCompressor.take());
+    m_encoding = m_negotiatedEncoding;
+    m_streaming.storeRelease(m_negotiatedStreaming);
+}
+
+QVariantMap ITransportClient::connectionOptions() const
+{
+    return m_connectionOptions;
+}
+
+void ITransportClient::resetConnection()
+{
+    dropQueue();
+    m_decoder.clear();
+    m_decoder.setMode(QAFrameDecoder::JsonMode);
+    m_encoding = JsonEncoding;
+    m_streaming.storeRelease(0);
+    m_compressor.reset();
+}
+
+void ITransportClient::resetNegotiation()
+{
+    m_negotiatedFraming = QAFrameDecoder::JsonMode;
+    m_negotiatedEncoding = JsonEncoding;
+    m_negotiatedStreaming = false;
+    m_connectionOptions.clear();
+    m_sharedMemory.reset();
+    m_negotiatedCompressor.reset();
+    m_requestIds.clear();
+}
+
+bool ITransportClient::isStreaming() const
 {
+    return m_streaming.loadAcquire();
 }
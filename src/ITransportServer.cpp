@@ -1,9 +1,8 @@
 #include <qt_qa_engine/ITransportClient.h>
 #include <qt_qa_engine/ITransportServer.h>
+#include <qt_qa_engine/QATrace.h>
 
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonParseError>
 
 #include <QLoggingCategory>
 
@@ -18,6 +17,7 @@ void ITransportServer::registerClient(ITransportClient* client)
 {
     connect(client, &ITransportClient::readyRead, this, &ITransportServer::readData);
     connect(client, &ITransportClient::disconnected, this, &ITransportServer::clientLost);
+    emit clientAdded(client);
 }
 
 void ITransportServer::readData(ITransportClient* client)
@@ -25,36 +25,44 @@ void ITransportServer::readData(ITransportClient* client)
     auto bytes = client->bytesAvailable();
     qCDebug(categoryITransportServer) << Q_FUNC_INFO << client << bytes;
 
-    static QByteArray requestData;
-    requestData.append(client->readAll());
-    qCDebug(categoryITransportServer).noquote() << requestData;
+    QAFrameDecoder* decoder = client->decoder();
+    decoder->append(client->readAll());
 
-    requestData.replace("}{", "}\n{"); // workaround packets join
-
-    const QList<QByteArray> commands = requestData.split('\n');
-    qCDebug(categoryITransportServer) << Q_FUNC_INFO << "Commands count:" << commands.length();
-
-    requestData.clear();
-    for (const QByteArray& cmd : commands)
+    QByteArray frame;
+    while (decoder->takeFrame(&frame))
     {
-        if (cmd.isEmpty())
-        {
-            continue;
-        }
         qCDebug(categoryITransportServer) << Q_FUNC_INFO << "Command:";
-        qCDebug(categoryITransportServer).noquote() << cmd;
+        qCDebug(categoryITransportServer).noquote() << frame;
 
-        QJsonParseError error;
-        QJsonDocument::fromJson(cmd, &error);
-        if (error.error != QJsonParseError::NoError)
+        QATrace::Span span("command:receive");
+        QString error;
+        QACommand command = QACommand::fromJson(frame, &error);
+        if (!command.isValid())
         {
-            qCDebug(categoryITransportServer) << Q_FUNC_INFO << "Partial data, waiting for more";
-            qCDebug(categoryITransportServer).noquote() << error.errorString();
-
-            requestData = cmd;
-            break;
+            // e.g. heartbeats answered by a bridge
+            if (error.isEmpty())
+            {
+                qCDebug(categoryITransportServer) << Q_FUNC_INFO << "Not an action, ignored";
+            }
+            else
+            {
+                qCWarning(categoryITransportServer) << Q_FUNC_INFO << "Invalid command:" << error;
+            }
+            continue;
         }
 
-        emit commandReceived(client, cmd);
+        command.received.start();
+        emit commandReceived(client, command);
     }
+
+    if (decoder->hasError())
+    {
+        qCWarning(categoryITransportServer) << Q_FUNC_INFO << client << "Malformed frame, closing";
+        decoder->clear();
+        client->close();
+        return;
+    }
+
+    qCDebug(categoryITransportServer)
+        << Q_FUNC_INFO << "Buffered bytes:" << decoder->bufferedBytes();
 }
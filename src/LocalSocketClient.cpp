@@ -0,0 +1,83 @@
+#include <qt_qa_engine/LocalSocketClient.h>
+
+#include <QDebug>
+#include <QLocalSocket>
+
+LocalSocketClient::LocalSocketClient(QLocalSocket* socket, QObject* parent)
+    : ITransportClient(parent)
+    , m_socket(socket)
+{
+    connect(m_socket, &QLocalSocket::readyRead, this, &LocalSocketClient::onReadyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &LocalSocketClient::onDisconnected);
+    connect(m_socket, &QLocalSocket::bytesWritten, this, &LocalSocketClient::onBytesWritten);
+}
+
+qint64 LocalSocketClient::bytesAvailable()
+{
+    return m_socket->bytesAvailable();
+}
+
+QByteArray LocalSocketClient::readAll()
+{
+    return m_socket->readAll();
+}
+
+bool LocalSocketClient::isOpen()
+{
+    return m_socket->isOpen();
+}
+
+bool LocalSocketClient::isConnected()
+{
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+void LocalSocketClient::close()
+{
+    m_socket->close();
+}
+
+qint64 LocalSocketClient::write(const QByteArray& data)
+{
+    return m_socket->write(data);
+}
+
+bool LocalSocketClient::flush()
+{
+    return m_socket->flush();
+}
+
+qint64 LocalSocketClient::bytesToWrite()
+{
+    return m_socket->bytesToWrite();
+}
+
+bool LocalSocketClient::waitForBytesWritten(int msecs)
+{
+    return m_socket->waitForBytesWritten(msecs);
+}
+
+bool LocalSocketClient::waitForReadyRead(int msecs)
+{
+    return m_socket->waitForReadyRead(msecs);
+}
+
+void LocalSocketClient::onDisconnected()
+{
+    emit disconnected(this);
+}
+
+void LocalSocketClient::onConnected()
+{
+    emit connected(this);
+}
+
+void LocalSocketClient::onReadyRead()
+{
+    emit readyRead(this);
+}
+
+void LocalSocketClient::onBytesWritten(qint64 bytes)
+{
+    emit bytesWritten(this, bytes);
+}
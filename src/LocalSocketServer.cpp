@@ -0,0 +1,82 @@
+#include <qt_qa_engine/LocalSocketClient.h>
+#include <qt_qa_engine/LocalSocketServer.h>
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <QDebug>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryLocalSocketServer, "autoqa.qaengine.transport.server", QtWarningMsg)
+
+LocalSocketServer::LocalSocketServer(const QString& name, QObject* parent)
+    : ITransportServer(parent)
+    , m_name(name)
+    , m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &LocalSocketServer::newConnection);
+}
+
+LocalSocketServer::~LocalSocketServer()
+{
+    m_server->close();
+}
+
+void LocalSocketServer::start()
+{
+    qCDebug(categoryLocalSocketServer) << Q_FUNC_INFO;
+    if (m_server->isListening())
+    {
+        return;
+    }
+
+    if (!m_server->listen(m_name))
+    {
+        qCWarning(categoryLocalSocketServer) << Q_FUNC_INFO << m_server->errorString();
+        // socket file may be left behind by a crashed process, live instance accepts connections
+        if (m_server->serverError() == QAbstractSocket::AddressInUseError && !isServerAlive())
+        {
+            QLocalServer::removeServer(m_name);
+            m_server->listen(m_name);
+        }
+    }
+
+    if (!m_server->isListening())
+    {
+        qCWarning(categoryLocalSocketServer) << Q_FUNC_INFO << m_server->errorString();
+        // server lives on transport thread
+        QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+        return;
+    }
+    else
+    {
+        qCWarning(categoryLocalSocketServer) << Q_FUNC_INFO << "listening:" << m_server->fullServerName();
+
+        QVariantMap address;
+        address.insert(QStringLiteral("socket"), m_server->fullServerName());
+        emit listening(this, address);
+    }
+}
+
+bool LocalSocketServer::isServerAlive() const
+{
+    QLocalSocket probe;
+    probe.connectToServer(m_name);
+    const bool alive = probe.waitForConnected(s_probeTimeout);
+    qCDebug(categoryLocalSocketServer) << Q_FUNC_INFO << m_name << alive << probe.errorString();
+    probe.abort();
+    return alive;
+}
+
+void LocalSocketServer::newConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection())
+    {
+        qCDebug(categoryLocalSocketServer) << Q_FUNC_INFO << "New connection on:" << m_name;
+        auto client = new LocalSocketClient(socket);
+        registerClient(client);
+    }
+}
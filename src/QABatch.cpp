@@ -0,0 +1,274 @@
+#include <qt_qa_engine/QABatch.h>
+#include <qt_qa_engine/QAPendingEvent.h>
+#include <qt_qa_engine/QASession.h>
+
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryBatch, "autoqa.qaengine.batch", QtWarningMsg)
+
+namespace
+{
+
+// actions which change the connection itself or never reply
+bool isBatchable(const QString& action)
+{
+    return action != QLatin1String("batch") && action != QLatin1String("appConnect")
+           && action != QLatin1String("startAnalyze") && action != QLatin1String("stopAnalyze")
+           && action != QLatin1String("initialize");
+}
+
+} // namespace
+
+QABatch::QABatch(ITransportClient* client,
+                 const QVariant& requestId,
+                 const QVariantList& items,
+                 const QVariantMap& options,
+                 const Dispatcher& dispatcher,
+                 QObject* parent)
+    : ITransportClient(parent)
+    , m_client(client)
+    , m_requestId(requestId)
+    , m_items(items)
+    , m_stopOnError(options.value(QStringLiteral("stopOnError"), true).toBool())
+    , m_dispatcher(dispatcher)
+    , m_pending(new QAPendingEvent(this))
+    , m_itemTimer(new QTimer(this))
+{
+    connect(m_pending, &QAPendingEvent::cancelled, this, &QABatch::onCancelled);
+
+    m_itemTimer->setSingleShot(true);
+    m_itemTimer->setInterval(s_itemTimeout);
+    connect(m_itemTimer, &QTimer::timeout, this, &QABatch::onItemTimeout);
+}
+
+qint64 QABatch::bytesAvailable()
+{
+    return 0;
+}
+
+QByteArray QABatch::readAll()
+{
+    return QByteArray();
+}
+
+bool QABatch::isOpen()
+{
+    return m_client && m_client->isOpen();
+}
+
+bool QABatch::isConnected()
+{
+    return m_client && m_client->isConnected();
+}
+
+void QABatch::close()
+{
+}
+
+qint64 QABatch::write(const QByteArray& data)
+{
+    qCWarning(categoryBatch) << Q_FUNC_INFO << "Raw data is not supported in batch, dropping"
+                             << data.size();
+    return data.size();
+}
+
+bool QABatch::flush()
+{
+    return true;
+}
+
+qint64 QABatch::bytesToWrite()
+{
+    return 0;
+}
+
+bool QABatch::waitForBytesWritten(int)
+{
+    return false;
+}
+
+bool QABatch::waitForReadyRead(int)
+{
+    return false;
+}
+
+QVariant QABatch::payloadValue(const QByteArray& payload)
+{
+    return m_client ? m_client->payloadValue(payload) : QVariant();
+}
+
+ITransportClient* QABatch::sessionClient()
+{
+    return m_client ? m_client->sessionClient() : this;
+}
+
+QVariant QABatch::sessionRequestId() const
+{
+    // never equal to an id parsed from JSON
+    return QVariant::fromValue(static_cast<QObject*>(const_cast<QABatch*>(this)));
+}
+
+void QABatch::start()
+{
+    qCDebug(categoryBatch) << Q_FUNC_INFO << this << m_requestId << m_items.size();
+
+    if (QASession* session = QASession::find(this))
+    {
+        session->trackPending(m_requestId, m_pending);
+    }
+    runNext();
+}
+
+void QABatch::writeReply(const QVariant& requestId, const QVariant& value, int status)
+{
+    if (requestId.toInt() != m_current || m_current != m_results.size())
+    {
+        // late reply of an item which timed out
+        qCWarning(categoryBatch) << Q_FUNC_INFO << "Unexpected reply for item" << requestId;
+        return;
+    }
+    m_itemTimer->stop();
+
+    QVariantMap result;
+    result.insert(QStringLiteral("status"), status);
+    result.insert(QStringLiteral("value"), value);
+    m_results.append(result);
+
+    if ((status != 0 && m_stopOnError) || m_pending->isCancelled())
+    {
+        finish();
+        return;
+    }
+
+    // items may reply synchronously from inside dispatch, keep the stack flat
+    QMetaObject::invokeMethod(this, "runNext", Qt::QueuedConnection);
+}
+
+void QABatch::runNext()
+{
+    // the client object may outlive its connection, its session is closed on disconnect
+    if (!m_client || !QASession::find(m_client))
+    {
+        qCDebug(categoryBatch) << Q_FUNC_INFO << "Client is gone";
+        deleteLater();
+        return;
+    }
+
+    m_current = m_results.size();
+    if (m_current >= m_items.size() || m_pending->isCancelled())
+    {
+        finish();
+        return;
+    }
+
+    const QVariantMap item = m_items.at(m_current).toMap();
+    const QString action = item.value(QStringLiteral("action")).toString();
+
+    QString error;
+    QVariantList params;
+    if (action.isEmpty() || !isBatchable(action))
+    {
+        error = QStringLiteral("action %1 is not allowed in batch").arg(action);
+    }
+    else
+    {
+        params = resolve(item.value(QStringLiteral("params")), &error).toList();
+    }
+
+    m_itemTimer->start();
+    beginRequest(m_current);
+    if (error.isEmpty())
+    {
+        qCDebug(categoryBatch) << Q_FUNC_INFO << m_current << action << params;
+
+        QASession::Scope scope(QASession::find(this));
+        m_dispatcher(this, action, params);
+    }
+    else
+    {
+        qCWarning(categoryBatch) << Q_FUNC_INFO << m_current << error;
+        sendReply(m_current, error, 1);
+    }
+    endRequest();
+}
+
+QVariant QABatch::resolve(const QVariant& param, QString* error) const
+{
+    if (param.userType() == QMetaType::QVariantList)
+    {
+        QVariantList resolved;
+        for (const QVariant& item : param.toList())
+        {
+            resolved.append(resolve(item, error));
+        }
+        return resolved;
+    }
+
+    const QVariantMap map = param.toMap();
+    if (param.userType() != QMetaType::QVariantMap || !map.contains(QStringLiteral("$ref")))
+    {
+        return param;
+    }
+
+    // {"$ref": N} is element id replied by item N, "index" picks one of multiple elements
+    const int ref = map.value(QStringLiteral("$ref")).toInt();
+    if (ref < 0 || ref >= m_results.size())
+    {
+        *error = QStringLiteral("$ref %1 does not point to a previous item").arg(ref);
+        return QVariant();
+    }
+
+    QVariant value = m_results.at(ref).toMap().value(QStringLiteral("value"));
+    if (value.userType() == QMetaType::QVariantList)
+    {
+        value = value.toList().value(map.value(QStringLiteral("index"), 0).toInt());
+    }
+
+    const QVariantMap element = value.toMap();
+    if (element.contains(QStringLiteral("ELEMENT")))
+    {
+        return element.value(QStringLiteral("ELEMENT"));
+    }
+    return value;
+}
+
+void QABatch::onCancelled()
+{
+    qCDebug(categoryBatch) << Q_FUNC_INFO << this << m_requestId << m_pending->result();
+
+    // running item replies cancelled, the batch finishes with that reply
+    if (QASession* session = QASession::find(this))
+    {
+        session->cancel(sessionRequestId(), m_pending->result().toString(), m_pending->status());
+    }
+}
+
+void QABatch::onItemTimeout()
+{
+    qCWarning(categoryBatch) << Q_FUNC_INFO << this << "item" << m_current << "did not reply";
+
+    writeReply(m_current, QStringLiteral("timeout"), QASession::s_timeoutStatus);
+}
+
+void QABatch::finish()
+{
+    qCDebug(categoryBatch) << Q_FUNC_INFO << this << m_results.size() << "of" << m_items.size();
+
+    m_current = -1;
+    m_itemTimer->stop();
+    if (m_client)
+    {
+        if (m_pending->isCancelled())
+        {
+            m_client->sendReply(m_requestId, m_pending->result(), m_pending->status());
+        }
+        else
+        {
+            m_client->sendReply(m_requestId, m_results);
+        }
+    }
+    m_pending->setCompleted();
+    deleteLater();
+}
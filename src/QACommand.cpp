@@ -0,0 +1,62 @@
+#include <qt_qa_engine/QACommand.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QJsonValue>
+
+bool QACommand::isValid() const
+{
+    return !action.isEmpty();
+}
+
+bool QACommand::isExpired() const
+{
+    return deadline >= 0 && remainingTime() <= 0;
+}
+
+qint64 QACommand::remainingTime() const
+{
+    if (deadline < 0)
+    {
+        return -1;
+    }
+    return received.isValid() ? qMax<qint64>(0, deadline - received.elapsed()) : deadline;
+}
+
+QACommand QACommand::fromJson(const QByteArray& data, QString* errorString)
+{
+    QACommand command;
+
+    QJsonParseError error;
+    const QJsonDocument json = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        if (errorString)
+        {
+            *errorString = error.errorString();
+        }
+        return command;
+    }
+
+    const QJsonObject object = json.object();
+    if (object.value(QStringLiteral("cmd")).toString() != QLatin1String("action"))
+    {
+        return command;
+    }
+
+    const QJsonValue id = object.value(QStringLiteral("id"));
+    if (!id.isUndefined() && !id.isNull())
+    {
+        command.id = id.toVariant();
+    }
+    command.action = object.value(QStringLiteral("action")).toString();
+    command.params = object.value(QStringLiteral("params")).toArray().toVariantList();
+    const QJsonValue deadline = object.value(QStringLiteral("deadline"));
+    if (deadline.isDouble() && deadline.toDouble() >= 0)
+    {
+        command.deadline = qint64(deadline.toDouble());
+    }
+    return command;
+}
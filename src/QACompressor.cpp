@@ -0,0 +1,228 @@
+#include <qt_qa_engine/QACompressor.h>
+
+#include <QProcessEnvironment>
+
+#include <cstring>
+
+#ifdef MO_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MO_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryCompressor, "autoqa.qaengine.transport.compressor", QtWarningMsg)
+
+QStringList QACompressor::availableMethods()
+{
+    QStringList methods;
+#ifdef MO_USE_ZSTD
+    methods.append(methodName(ZstdStreamMethod));
+#endif
+#ifdef MO_USE_ZLIB
+    methods.append(methodName(ZlibStreamMethod));
+#endif
+    methods.append(methodName(QCompressMethod));
+    return methods;
+}
+
+QACompressor::Method QACompressor::methodFromName(const QString& name)
+{
+    if (!availableMethods().contains(name))
+    {
+        return NoCompression;
+    }
+    if (name == QLatin1String("zstd"))
+    {
+        return ZstdStreamMethod;
+    }
+    if (name == QLatin1String("zlib"))
+    {
+        return ZlibStreamMethod;
+    }
+    if (name == QLatin1String("qcompress"))
+    {
+        return QCompressMethod;
+    }
+    return NoCompression;
+}
+
+QString QACompressor::methodName(QACompressor::Method method)
+{
+    switch (method)
+    {
+        case ZstdStreamMethod:
+            return QStringLiteral("zstd");
+        case ZlibStreamMethod:
+            return QStringLiteral("zlib");
+        case QCompressMethod:
+            return QStringLiteral("qcompress");
+        case NoCompression:
+        default:
+            return QString();
+    }
+}
+
+int QACompressor::payloadLevel()
+{
+    static const int level = qBound(
+        -1,
+        QProcessEnvironment::systemEnvironment().value("QAENGINE_COMPRESSION_LEVEL", "1").toInt(),
+        9);
+    return level;
+}
+
+QACompressor::QACompressor(QACompressor::Method method, int level, int threshold)
+    : m_method(method)
+    , m_level(level)
+    , m_threshold(threshold)
+{
+    switch (m_method)
+    {
+        case QCompressMethod:
+            m_level = m_level < 0 ? 1 : qMin(m_level, 9);
+            m_valid = true;
+            break;
+#ifdef MO_USE_ZLIB
+        case ZlibStreamMethod:
+            m_level = m_level < 0 ? 1 : qMin(m_level, 9);
+            m_zlib = new z_stream;
+            memset(m_zlib, 0, sizeof(z_stream));
+            m_valid = deflateInit(m_zlib, m_level) == Z_OK;
+            break;
+#endif
+#ifdef MO_USE_ZSTD
+        case ZstdStreamMethod:
+            m_level = m_level < 0 ? 3 : qMin(m_level, ZSTD_maxCLevel());
+            m_zstd = ZSTD_createCCtx();
+            m_valid = m_zstd
+                      && !ZSTD_isError(
+                          ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_compressionLevel, m_level));
+            break;
+#endif
+        default:
+            break;
+    }
+
+    if (!m_valid)
+    {
+        qCWarning(categoryCompressor) << Q_FUNC_INFO << "Can't initialize" << methodName(method);
+    }
+}
+
+QACompressor::~QACompressor()
+{
+#ifdef MO_USE_ZLIB
+    if (m_zlib)
+    {
+        deflateEnd(m_zlib);
+        delete m_zlib;
+    }
+#endif
+#ifdef MO_USE_ZSTD
+    if (m_zstd)
+    {
+        ZSTD_freeCCtx(m_zstd);
+    }
+#endif
+}
+
+bool QACompressor::isValid() const
+{
+    return m_valid;
+}
+
+QACompressor::Method QACompressor::method() const
+{
+    return m_method;
+}
+
+int QACompressor::level() const
+{
+    return m_level;
+}
+
+int QACompressor::threshold() const
+{
+    return m_threshold;
+}
+
+bool QACompressor::compress(const QByteArray& data, QByteArray* compressed)
+{
+    if (!m_valid)
+    {
+        return false;
+    }
+
+    switch (m_method)
+    {
+        case QCompressMethod:
+            *compressed = qCompress(data, m_level);
+            return !compressed->isEmpty();
+#ifdef MO_USE_ZLIB
+        case ZlibStreamMethod:
+        {
+            QByteArray out(int(deflateBound(m_zlib, uLong(data.size()))) + 64, Qt::Uninitialized);
+            m_zlib->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+            m_zlib->avail_in = uInt(data.size());
+            m_zlib->next_out = reinterpret_cast<Bytef*>(out.data());
+            m_zlib->avail_out = uInt(out.size());
+            for (;;)
+            {
+                const int ret = deflate(m_zlib, Z_SYNC_FLUSH);
+                if (ret != Z_OK && ret != Z_BUF_ERROR)
+                {
+                    qCWarning(categoryCompressor) << Q_FUNC_INFO << "deflate failed:" << ret;
+                    m_valid = false;
+                    return false;
+                }
+                if (m_zlib->avail_out > 0)
+                {
+                    break;
+                }
+                const int used = out.size();
+                out.resize(used * 2);
+                m_zlib->next_out = reinterpret_cast<Bytef*>(out.data() + used);
+                m_zlib->avail_out = uInt(out.size() - used);
+            }
+            out.resize(out.size() - int(m_zlib->avail_out));
+            *compressed = out;
+            return true;
+        }
+#endif
+#ifdef MO_USE_ZSTD
+        case ZstdStreamMethod:
+        {
+            QByteArray out(int(ZSTD_compressBound(size_t(data.size()))) + 64, Qt::Uninitialized);
+            ZSTD_inBuffer input = {data.constData(), size_t(data.size()), 0};
+            ZSTD_outBuffer output = {out.data(), size_t(out.size()), 0};
+            for (;;)
+            {
+                const size_t remaining = ZSTD_compressStream2(m_zstd, &output, &input, ZSTD_e_flush);
+                if (ZSTD_isError(remaining))
+                {
+                    qCWarning(categoryCompressor)
+                        << Q_FUNC_INFO << "zstd failed:" << ZSTD_getErrorName(remaining);
+                    m_valid = false;
+                    return false;
+                }
+                if (remaining == 0)
+                {
+                    break;
+                }
+                out.resize(out.size() * 2);
+                output.dst = out.data();
+                output.size = size_t(out.size());
+            }
+            out.resize(int(output.pos));
+            *compressed = out;
+            return true;
+        }
+#endif
+        default:
+            return false;
+    }
+}
@@ -1,8 +1,16 @@
 #include <qt_qa_engine/IEnginePlatform.h>
 #include <qt_qa_engine/ITransportClient.h>
+#include <qt_qa_engine/QABatch.h>
+#include <qt_qa_engine/QAHandleTable.h>
+#include <qt_qa_engine/QARegistry.h>
+#include <qt_qa_engine/QAStats.h>
+#include <qt_qa_engine/QATrace.h>
 #include <qt_qa_engine/QAEngine.h>
 #include <qt_qa_engine/QAEngineSocketClient.h>
+#include <qt_qa_engine/QASession.h>
+#include <qt_qa_engine/LocalSocketServer.h>
 #include <qt_qa_engine/TCPSocketServer.h>
+#include <qt_qa_engine/WebDriverServer.h>
 
 #if defined(MO_USE_QUICK)
 #include <QQuickWindow>
@@ -14,6 +22,8 @@
 #include <qt_qa_engine/WidgetsEnginePlatform.h>
 #endif
 
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDebug>
@@ -24,7 +34,9 @@
 #include <QJsonObject>
 #include <QMetaMethod>
 #include <QProcessEnvironment>
+#include <QReadWriteLock>
 #include <QTcpSocket>
+#include <QThread>
 #include <QTimer>
 #include <QWindow>
 
@@ -34,6 +46,7 @@
 
 #include <private/qhooks_p.h>
 #include <private/qmetaobject_p.h>
+#include <private/qobject_p.h>
 #include <private/qmetatype_p.h>
 
 #include <array>
@@ -49,9 +62,25 @@ QAEngine* s_instance = nullptr;
 QString s_processName = "qaengine";
 bool s_exiting = false;
 
+// object hooks run on any thread: they check these before touching GUI thread state
+QAtomicInt s_hooksEnabled;
+Qt::HANDLE s_guiThreadId = nullptr;
+
+// objects destroyed on other threads, pushed without locks and drained on GUI thread
+struct RemovedObject
+{
+    QObject* object;
+    RemovedObject* next;
+};
+QAtomicPointer<RemovedObject> s_removedObjects;
+
 QHash<QWindow*, IEnginePlatform*> s_windows;
 QWindow* s_lastFocusWindow = nullptr;
 
+// registered from app startup code, possibly before the engine or off GUI thread
+QReadWriteLock s_commandsLock;
+QHash<QString, QAEngine::CommandHandler> s_commands;
+
 inline QGenericArgument qVariantToArgument(const QVariant& variant)
 {
     if (variant.isValid() && !variant.isNull())
@@ -61,6 +90,197 @@ inline QGenericArgument qVariantToArgument(const QVariant& variant)
     return QGenericArgument();
 }
 
+// methods by name, derived class methods first, built once per class
+QHash<const QMetaObject*, QHash<QByteArray, QVector<QMetaMethod>>> s_methodCache;
+
+QHash<QByteArray, QVector<QMetaMethod>> methodTable(const QMetaObject* metaObject)
+{
+    QHash<QByteArray, QVector<QMetaMethod>> table;
+    for (const QMetaObject* mo = metaObject; mo; mo = mo->superClass())
+    {
+        for (int i = mo->methodOffset(); i < mo->methodCount(); i++)
+        {
+            const QMetaMethod method = mo->method(i);
+            table[method.name()].append(method);
+        }
+    }
+    return table;
+}
+
+QVector<QMetaMethod> findMethods(QObject* object, const QByteArray& name)
+{
+    const QMetaObject* metaObject = object->metaObject();
+    if (QObjectPrivate::get(object)->metaObject)
+    {
+        // dynamic meta objects (QML components) live and die with their objects, never cache them
+        QVector<QMetaMethod> methods;
+        for (const QMetaObject* mo = metaObject; mo; mo = mo->superClass())
+        {
+            for (int i = mo->methodOffset(); i < mo->methodCount(); i++)
+            {
+                if (mo->method(i).name() == name)
+                {
+                    methods.append(mo->method(i));
+                }
+            }
+        }
+        return methods;
+    }
+
+    auto it = s_methodCache.find(metaObject);
+    if (it == s_methodCache.end())
+    {
+        it = s_methodCache.insert(metaObject, methodTable(metaObject));
+    }
+    return it->value(name);
+}
+
+// chosen overload and target type of every argument, UnknownType passes argument as is
+struct Overload
+{
+    QMetaMethod method;
+    QVector<int> targetTypes;
+};
+
+// overloads by argument type signature, resolved once per class
+QHash<const QMetaObject*, QHash<QByteArray, Overload>> s_overloadCache;
+
+bool isNumericType(int type)
+{
+    switch (type)
+    {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// higher is better, negative if argument can't be passed as this type
+int conversionScore(const QVariant& arg, int type)
+{
+    if (arg.userType() == type)
+    {
+        return 4;
+    }
+    if (type == QMetaType::QVariant)
+    {
+        return 3;
+    }
+    if (isNumericType(arg.userType()) && isNumericType(type))
+    {
+        return 2;
+    }
+    if (type == QMetaType::UnknownType)
+    {
+        // not registered parameter type, leave it to invocation
+        return 0;
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return arg.canConvert(QMetaType(type)) ? 1 : -1;
+#else
+    return arg.canConvert(type) ? 1 : -1;
+#endif
+}
+
+// first skip parameters are not taken from args, e.g. client socket
+Overload resolveOverload(QObject* object,
+                         const QByteArray& name,
+                         const QVariantList& args,
+                         int skip,
+                         bool* found)
+{
+    const bool cacheable = !QObjectPrivate::get(object)->metaObject;
+    QByteArray key;
+    if (cacheable)
+    {
+        key = name + '/' + QByteArray::number(skip);
+        for (const QVariant& arg : args)
+        {
+            key += ',' + QByteArray::number(arg.userType());
+        }
+
+        auto table = s_overloadCache.constFind(object->metaObject());
+        if (table != s_overloadCache.constEnd())
+        {
+            auto cached = table->constFind(key);
+            if (cached != table->constEnd())
+            {
+                *found = true;
+                return *cached;
+            }
+        }
+    }
+
+    const QVector<QMetaMethod> methods = findMethods(object, name);
+    *found = !methods.isEmpty();
+
+    Overload best;
+    int bestScore = -1;
+    for (const QMetaMethod& method : methods)
+    {
+        const int count = method.parameterCount() - skip;
+        if (count < 0 || count > args.size())
+        {
+            continue;
+        }
+
+        // extra arguments are ignored, but exact arity wins a tie
+        int score = count == args.size() ? 1 : 0;
+        QVector<int> targetTypes;
+        for (int i = 0; i < count && score >= 0; i++)
+        {
+            const int type = method.parameterType(i + skip);
+            const int argScore = conversionScore(args.at(i), type);
+            score = argScore < 0 ? -1 : score + argScore;
+            targetTypes.append(type);
+        }
+
+        // equal score keeps the first declared, derived class first
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best.method = method;
+            best.targetTypes = targetTypes;
+        }
+    }
+
+    if (cacheable && *found)
+    {
+        // failed resolution is cached as well, as an invalid method
+        s_overloadCache[object->metaObject()].insert(key, best);
+    }
+    return best;
+}
+
+void convertArguments(const Overload& overload, QVariantList* args)
+{
+    for (int i = 0; i < overload.targetTypes.size(); i++)
+    {
+        const int type = overload.targetTypes.at(i);
+        QVariant& arg = (*args)[i];
+        if (type == QMetaType::UnknownType || type == QMetaType::QVariant || arg.userType() == type)
+        {
+            continue;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        arg.convert(QMetaType(type));
+#else
+        arg.convert(type);
+#endif
+    }
+}
+
 } // namespace
 
 bool QAEngine::isLoaded()
@@ -70,22 +290,69 @@ bool QAEngine::isLoaded()
 
 void QAEngine::objectCreated(QObject* o)
 {
-    if (!s_instance)
+    // objects of other threads are never shown to platforms, nothing to hand off
+    if (!s_hooksEnabled.loadAcquire() || QThread::currentThreadId() != s_guiThreadId)
     {
         return;
     }
 
+    flushRemovedObjects();
     s_instance->addItem(o);
 }
 
 void QAEngine::objectRemoved(QObject* o)
 {
-    if (!s_instance)
+    if (!s_hooksEnabled.loadAcquire())
+    {
+        return;
+    }
+
+    if (QThread::currentThreadId() == s_guiThreadId)
     {
+        s_instance->removeItem(o);
         return;
     }
 
-    s_instance->removeItem(o);
+    // platform caches hold GUI objects only, handles may refer to objects of any thread
+    if (!QASession::hasTrackedItems() && !QAHandleTable::hasHandles())
+    {
+        return;
+    }
+
+    RemovedObject* removed = new RemovedObject{o, nullptr};
+    RemovedObject* head = nullptr;
+    do
+    {
+        head = s_removedObjects.loadAcquire();
+        removed->next = head;
+    } while (!s_removedObjects.testAndSetOrdered(head, removed));
+
+    // first object after a drain schedules the next one
+    if (!head)
+    {
+        QMetaObject::invokeMethod(s_instance, "drainRemovedObjects", Qt::QueuedConnection);
+    }
+}
+
+void QAEngine::flushRemovedObjects()
+{
+    if (s_instance && s_removedObjects.loadAcquire())
+    {
+        s_instance->drainRemovedObjects();
+    }
+}
+
+void QAEngine::drainRemovedObjects()
+{
+    RemovedObject* removed = s_removedObjects.fetchAndStoreAcquire(nullptr);
+    while (removed)
+    {
+        // pointer is only used as a key, the object is gone
+        removeItem(removed->object);
+        RemovedObject* next = removed->next;
+        delete removed;
+        removed = next;
+    }
 }
 
 IEnginePlatform* QAEngine::getPlatform(bool silent)
@@ -123,13 +390,28 @@ void QAEngine::initializeSocket()
                             << QStringLiteral("2.0.0-dev");
 #endif
 
-    m_socketServer->start();
+    m_transportThread->start();
+    QMetaObject::invokeMethod(m_socketServer, "start", Qt::QueuedConnection);
+    if (m_webDriverServer)
+    {
+        QMetaObject::invokeMethod(m_webDriverServer, "start", Qt::QueuedConnection);
+    }
+    if (m_bridgeClient)
+    {
+        QMetaObject::invokeMethod(m_bridgeClient, "start", Qt::QueuedConnection);
+    }
 }
 
 void QAEngine::initializeEngine()
 {
-    disconnect(
-        m_socketServer, &ITransportServer::commandReceived, this, &QAEngine::initializeEngine);
+    for (ITransportServer* server : {m_socketServer, m_webDriverServer, m_bridgeClient})
+    {
+        if (server)
+        {
+            disconnect(
+                server, &ITransportServer::commandReceived, this, &QAEngine::initializeEngine);
+        }
+    }
 
     if (s_engineLoaded)
     {
@@ -143,6 +425,8 @@ void QAEngine::initializeEngine()
     qCDebug(categoryEngine) << Q_FUNC_INFO << endl;
 #endif
 
+    s_guiThreadId = QThread::currentThreadId();
+    s_hooksEnabled.storeRelease(1);
     qtHookData[QHooks::RemoveQObject] = reinterpret_cast<quintptr>(&QAEngine::objectRemoved);
     qtHookData[QHooks::AddQObject] = reinterpret_cast<quintptr>(&QAEngine::objectCreated);
 
@@ -152,6 +436,7 @@ void QAEngine::initializeEngine()
             {
                 qCDebug(categoryEngine) << Q_FUNC_INFO << "about to quit!";
                 s_exiting = true;
+                s_hooksEnabled.storeRelease(0);
             });
 
     connect(qGuiApp, &QGuiApplication::focusWindowChanged, this, &QAEngine::onFocusWindowChanged);
@@ -228,8 +513,11 @@ void QAEngine::onFocusWindowChanged(QWindow* window)
                 });
         QTimer::singleShot(0, platform, &IEnginePlatform::initialize);
 
-        if (m_analyzeActive)
-            platform->startAnalyze(m_analyzeSocket);
+        for (QASession* session : QASession::sessions())
+        {
+            if (session->isAnalyzeActive())
+                platform->startAnalyze(session->client());
+        }
 
         qDebug() << "!!! new platform !!!" << platform << window;
         s_windows.insert(window, platform);
@@ -252,20 +540,59 @@ void QAEngine::onPlatformReady()
     qCDebug(categoryEngine) << Q_FUNC_INFO << "Process name:" << s_processName
                             << "platform:" << platform << platform->window()
                             << platform->rootObject();
+
+    if (m_registry)
+    {
+        QVariantList windows;
+        for (auto it = s_windows.constBegin(); it != s_windows.constEnd(); ++it)
+        {
+            QVariantMap window;
+            window.insert(QStringLiteral("title"), it.key()->title());
+            window.insert(QStringLiteral("objectName"), it.key()->objectName());
+            window.insert(QStringLiteral("className"),
+                          QString::fromLatin1(it.key()->metaObject()->className()));
+            window.insert(QStringLiteral("visible"), it.key()->isVisible());
+            windows.append(window);
+        }
+        m_registry->setWindows(windows);
+        m_registry->markReady();
+    }
+}
+
+void QAEngine::onServerListening(ITransportServer* server, const QVariantMap& address)
+{
+    qCDebug(categoryEngine) << Q_FUNC_INFO << server << address;
+
+    if (m_registry)
+    {
+        m_registry->setAddress(address);
+        // ready marker is for discovery, it can't wait for the first command to create platforms
+        initializeEngine();
+    }
+}
+
+void QAEngine::clientAdded(ITransportClient* client)
+{
+    qCDebug(categoryEngine) << Q_FUNC_INFO << client;
+
+    // commands are only accepted while the session exists, see processCommand
+    QASession::forClient(client);
 }
 
 void QAEngine::clientLost(ITransportClient* client)
 {
     qCDebug(categoryEngine) << Q_FUNC_INFO << client;
 
-    if (client == m_analyzeSocket) {
+    // bridge client is reused by the next connection
+    client->resetNegotiation();
+
+    if (QASession* session = QASession::find(client))
+    {
         for (auto platform : s_windows)
         {
-            platform->stopAnalyze();
+            platform->sessionClosed(session);
         }
-
-        m_analyzeActive = false;
-        m_analyzeSocket = nullptr;
+        QASession::close(client);
     }
 }
 
@@ -282,6 +609,9 @@ QAEngine::QAEngine(QObject* parent)
     : QObject(parent)
 {
     int port = QProcessEnvironment::systemEnvironment().value("QAENGINE_PORT", "8888").toInt();
+    QString socketName = QProcessEnvironment::systemEnvironment().value("QAENGINE_SOCKET");
+    int webDriverPort =
+        QProcessEnvironment::systemEnvironment().value("QAENGINE_WEBDRIVER_PORT", "0").toInt();
     QString defaultRules = "autoqa.qaengine.*.debug=false\n"
     //                        "autoqa.qaengine.platform.generic=true\n"
     //                        "autoqa.qaengine.platform.quick=true\n"
@@ -289,21 +619,99 @@ QAEngine::QAEngine(QObject* parent)
     //                        "autoqa.qaengine.transport.server.debug=true\n";
                            "autoqa.qaengine.engine.debug=true\n";
     QString filterRules = QProcessEnvironment::systemEnvironment().value("QAENGINE_FILTER_RULES", defaultRules);
-    qDebug() << "QAEngine port:" << port;
-    m_socketServer = new TCPSocketServer(port, this);
+    QString registryDir = QProcessEnvironment::systemEnvironment().value("QAENGINE_REGISTRY_DIR");
+    QString tracePath = QProcessEnvironment::systemEnvironment().value("QAENGINE_TRACE");
+    QString bridge = QProcessEnvironment::systemEnvironment().value("QAENGINE_BRIDGE");
+    int bridgeHeartbeat = QProcessEnvironment::systemEnvironment()
+                              .value("QAENGINE_BRIDGE_HEARTBEAT",
+                                     QString::number(QAEngineSocketClient::s_defaultHeartbeatInterval))
+                              .toInt();
+    int bridgeTimeout =
+        QProcessEnvironment::systemEnvironment().value("QAENGINE_BRIDGE_TIMEOUT").toInt();
+    if (socketName.isEmpty())
+    {
+        qDebug() << "QAEngine port:" << port;
+        auto tcpServer = new TCPSocketServer(port);
+        tcpServer->setEphemeralFallback(!registryDir.isEmpty());
+        m_socketServer = tcpServer;
+    }
+    else
+    {
+        qDebug() << "QAEngine socket:" << socketName;
+        m_socketServer = new LocalSocketServer(socketName);
+    }
+
+    // socket I/O, framing and reply encoding run on transport thread,
+    // only decoded commands are queued to GUI thread
+    m_transportThread = new QThread(this);
+    m_transportThread->setObjectName(QStringLiteral("QAEngineTransport"));
+    m_socketServer->moveToThread(m_transportThread);
+    connect(m_transportThread, &QThread::finished, m_socketServer, &QObject::deleteLater);
+
+    if (webDriverPort > 0)
+    {
+        qDebug() << "QAEngine WebDriver port:" << webDriverPort;
+        m_webDriverServer = new WebDriverServer(webDriverPort);
+        m_webDriverServer->moveToThread(m_transportThread);
+        connect(m_transportThread, &QThread::finished, m_webDriverServer, &QObject::deleteLater);
+    }
+
+    if (!bridge.isEmpty())
+    {
+        qDebug() << "QAEngine bridge:" << bridge;
+        m_bridgeClient = new QAEngineSocketClient(bridge, bridgeHeartbeat, bridgeTimeout);
+        m_bridgeClient->moveToThread(m_transportThread);
+        connect(m_transportThread, &QThread::finished, m_bridgeClient, &QObject::deleteLater);
+    }
 
     qRegisterMetaType<QTcpSocket*>();
     qRegisterMetaType<ITransportClient*>();
     qRegisterMetaType<ITransportServer*>();
+    qRegisterMetaType<QACommand>();
     QLoggingCategory::setFilterRules(filterRules);
 
-    connect(m_socketServer, &ITransportServer::commandReceived, this, &QAEngine::initializeEngine);
-    connect(m_socketServer, &ITransportServer::commandReceived, this, &QAEngine::processCommand);
-    connect(m_socketServer, &ITransportServer::clientLost, this, &QAEngine::clientLost);
+    for (ITransportServer* server : {m_socketServer, m_webDriverServer, m_bridgeClient})
+    {
+        if (!server)
+        {
+            continue;
+        }
+        connect(server, &ITransportServer::commandReceived, this, &QAEngine::initializeEngine);
+        connect(server, &ITransportServer::commandReceived, this, &QAEngine::processCommand);
+        connect(server, &ITransportServer::clientAdded, this, &QAEngine::clientAdded);
+        connect(server, &ITransportServer::clientLost, this, &QAEngine::clientLost);
+        connect(server, &ITransportServer::listening, this, &QAEngine::onServerListening);
+    }
+
+    if (!tracePath.isEmpty())
+    {
+        qDebug() << "QAEngine trace:" << tracePath;
+        QATrace::start();
+        connect(qApp,
+                &QCoreApplication::aboutToQuit,
+                this,
+                [tracePath]()
+                {
+                    QATrace::stop();
+                    QATrace::save(tracePath);
+                });
+    }
+
+    if (!registryDir.isEmpty())
+    {
+        qDebug() << "QAEngine registry:" << registryDir;
+        m_registry = new QARegistry(registryDir);
+        // killed process keeps its entry until the next engine start cleans it up
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() { m_registry->remove(); });
+    }
 }
 
 QAEngine::~QAEngine()
 {
+    delete m_registry;
+
+    m_transportThread->quit();
+    m_transportThread->wait();
 }
 
 QString QAEngine::processName()
@@ -311,107 +719,115 @@ QString QAEngine::processName()
     return s_processName;
 }
 
+void QAEngine::registerCommand(const QString& command, const CommandHandler& handler)
+{
+    qCDebug(categoryEngine) << Q_FUNC_INFO << command;
+
+    QWriteLocker locker(&s_commandsLock);
+    s_commands.insert(command, handler);
+}
+
+void QAEngine::unregisterCommand(const QString& command)
+{
+    qCDebug(categoryEngine) << Q_FUNC_INFO << command;
+
+    QWriteLocker locker(&s_commandsLock);
+    s_commands.remove(command);
+}
+
+QAEngine::CommandHandler QAEngine::registeredCommand(const QString& command)
+{
+    QReadLocker locker(&s_commandsLock);
+    return s_commands.value(command);
+}
+
 bool QAEngine::metaInvoke(ITransportClient* socket,
                           QObject* object,
                           const QString& methodName,
                           const QVariantList& params,
                           bool* implemented)
 {
-    auto mo = object->metaObject();
-    do
+    bool found = false;
+    const Overload overload = resolveOverload(object, methodName.toLatin1(), params, 1, &found);
+    if (implemented)
+    {
+        *implemented = found;
+    }
+    if (!overload.method.isValid())
     {
-        for (int i = mo->methodOffset(); i < mo->methodOffset() + mo->methodCount(); i++)
+        if (found)
         {
-            if (mo->method(i).name() == methodName.toLatin1())
-            {
-                if (implemented)
-                {
-                    *implemented = true;
-                }
+            qWarning() << Q_FUNC_INFO << "No overload of" << methodName << "accepts" << params;
+        }
+        return false;
+    }
 
-                const QMetaMethod method = mo->method(i);
+    const QMetaMethod& method = overload.method;
+    QVariantList args = params;
+    convertArguments(overload, &args);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-                QVariantList args = params;
-
-                std::vector<const void*> data;
-                std::vector<const char*> names;
-                std::vector<const QtPrivate::QMetaTypeInterface*> types;
-
-                QMetaMethodReturnArgument r = {};
-                data.push_back(r.data);
-                names.push_back(r.name);
-                types.push_back(r.metaType);
-
-                auto socketArg = Q_ARG(ITransportClient*, socket);
-                data.push_back(socketArg.data);
-                names.push_back(socketArg.name);
-                types.push_back(socketArg.metaType);
-
-                for (int i = 0; i < (method.parameterCount() - 1) && args.count() > i; i++) {
-                    QMetaType paramType = method.parameterMetaType(i + 1);
-                    if (args[i].metaType() != paramType) {
-                        if (args[i].canConvert(paramType)) {
-                            args[i].convert(paramType);
-                        } else if (paramType == QMetaType(QMetaType::Type::QVariant)) {
-                            args[i] = QVariant::fromValue(args[i]);
-                        } else {
-                            qWarning() << Q_FUNC_INFO << "Can't convert" << args[i].metaType() << args[i] << "to" << paramType;
-                            return false;
-                        }
-                    }
-                    data.push_back(args[i].data());
-                    names.push_back(paramType.name());
-                    types.push_back(paramType.iface());
-                }
+    std::vector<const void*> data;
+    std::vector<const char*> names;
+    std::vector<const QtPrivate::QMetaTypeInterface*> types;
+
+    QMetaMethodReturnArgument r = {};
+    data.push_back(r.data);
+    names.push_back(r.name);
+    types.push_back(r.metaType);
+
+    auto socketArg = Q_ARG(ITransportClient*, socket);
+    data.push_back(socketArg.data);
+    names.push_back(socketArg.name);
+    types.push_back(socketArg.metaType);
+
+    for (int i = 0; i < overload.targetTypes.size(); i++) {
+        QMetaType paramType = method.parameterMetaType(i + 1);
+        if (paramType == QMetaType(QMetaType::Type::QVariant)) {
+            args[i] = QVariant::fromValue(args[i]);
+        }
+        data.push_back(args[i].data());
+        names.push_back(paramType.name());
+        types.push_back(paramType.iface());
+    }
 
-                QMetaMethodInvoker::InvokeFailReason reason =
-                    QMetaMethodInvoker::invokeImpl(method, object, Qt::DirectConnection,
-                                                   data.size(), &data[0], &names[0], &types[0]);
+    QMetaMethodInvoker::InvokeFailReason reason =
+        QMetaMethodInvoker::invokeImpl(method, object, Qt::DirectConnection,
+                                       data.size(), &data[0], &names[0], &types[0]);
 
-                if (int(reason) <= 0) {
-                    return reason == QMetaMethodInvoker::InvokeFailReason::None;
-                } else {
-                    qWarning() << Q_FUNC_INFO << "method not found!";
-                    return false;
-                }
+    if (int(reason) <= 0) {
+        return reason == QMetaMethodInvoker::InvokeFailReason::None;
+    } else {
+        qWarning() << Q_FUNC_INFO << "method not found!";
+        return false;
+    }
 #else
-                QGenericArgument arguments[9] = {QGenericArgument()};
-                for (int i = 0; i < (method.parameterCount() - 1) && params.count() > i; i++)
-                {
-                    if (method.parameterType(i + 1) == QMetaType::QVariant)
-                    {
-                        arguments[i] = Q_ARG(QVariant, params[i]);
-                    }
-                    else
-                    {
-                        arguments[i] = qVariantToArgument(params[i]);
-                    }
-                }
-
-                return QMetaObject::invokeMethod(object,
-                                                 methodName.toLatin1().constData(),
-                                                 Qt::DirectConnection,
-                                                 Q_ARG(ITransportClient*, socket),
-                                                 arguments[0],
-                                                 arguments[1],
-                                                 arguments[2],
-                                                 arguments[3],
-                                                 arguments[4],
-                                                 arguments[5],
-                                                 arguments[6],
-                                                 arguments[7],
-                                                 arguments[8]);
-#endif
-            }
-        }
-    } while ((mo = mo->superClass()));
-
-    if (implemented)
+    QGenericArgument arguments[9] = {QGenericArgument()};
+    for (int i = 0; i < overload.targetTypes.size() && i < 9; i++)
     {
-        *implemented = false;
+        if (overload.targetTypes.at(i) == QMetaType::QVariant)
+        {
+            arguments[i] = Q_ARG(QVariant, args[i]);
+        }
+        else
+        {
+            arguments[i] = qVariantToArgument(args[i]);
+        }
     }
-    return false;
+
+    return method.invoke(object,
+                         Qt::DirectConnection,
+                         Q_ARG(ITransportClient*, socket),
+                         arguments[0],
+                         arguments[1],
+                         arguments[2],
+                         arguments[3],
+                         arguments[4],
+                         arguments[5],
+                         arguments[6],
+                         arguments[7],
+                         arguments[8]);
+#endif
 }
 
 
@@ -421,128 +837,109 @@ bool QAEngine::metaInvokeRet(QObject* object,
                              bool* implemented,
                              QVariant *ret)
 {
-    auto mo = object->metaObject();
-    do
+    bool found = false;
+    const Overload overload = resolveOverload(object, methodName.toLatin1(), params, 0, &found);
+    if (implemented)
+    {
+        *implemented = found;
+    }
+    if (!overload.method.isValid())
     {
-        for (int i = mo->methodOffset(); i < mo->methodOffset() + mo->methodCount(); i++)
+        if (found)
         {
-            if (mo->method(i).name() == methodName.toLatin1())
-            {
-                if (implemented)
-                {
-                    *implemented = true;
-                }
+            qWarning() << Q_FUNC_INFO << "No overload of" << methodName << "accepts" << params;
+        }
+        return false;
+    }
 
-                const QMetaMethod method = mo->method(i);
-                QVariantList args = params;
+    const QMetaMethod& method = overload.method;
+    QVariantList args = params;
+    convertArguments(overload, &args);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    std::vector<const void*> data;
+    std::vector<const char*> names;
+    std::vector<const QtPrivate::QMetaTypeInterface*> types;
+
+    QMetaMethodReturnArgument r = {};
+    const QMetaType returnType = method.returnMetaType();
+    if (!ret || returnType == QMetaType(QMetaType::Type::Void)) {
+        data.push_back(r.data);
+        names.push_back(r.name);
+        types.push_back(r.metaType);
+    } else if (ret) {
+        ret->setValue(QVariant(returnType, ret->data()));
+
+        data.push_back(ret->data());
+        names.push_back(returnType.name());
+        types.push_back(returnType.iface());
+    }
 
-                std::vector<const void*> data;
-                std::vector<const char*> names;
-                std::vector<const QtPrivate::QMetaTypeInterface*> types;
-
-                QMetaMethodReturnArgument r = {};
-                const QMetaType returnType = method.returnMetaType();
-                if (!ret || returnType == QMetaType(QMetaType::Type::Void)) {
-                    data.push_back(r.data);
-                    names.push_back(r.name);
-                    types.push_back(r.metaType);
-                } else if (ret) {
-                    ret->setValue(QVariant(returnType, ret->data()));
-
-                    data.push_back(ret->data());
-                    names.push_back(returnType.name());
-                    types.push_back(returnType.iface());
-                }
-
-                for (int i = 0; i < method.parameterCount() && args.count() > i; i++) {
-                    QMetaType paramType = method.parameterMetaType(i);
-                    if (args[i].metaType() != paramType) {
-                        if (args[i].canConvert(paramType)) {
-                            args[i].convert(paramType);
-                        } else if (paramType == QMetaType(QMetaType::Type::QVariant)) {
-                            args[i] = QVariant::fromValue(args[i]);
-                        } else {
-                            qWarning() << Q_FUNC_INFO << "Can't convert" << args[i].metaType() << args[i] << "to" << paramType;
-                            return false;
-                        }
-                    }
-                    data.push_back(args[i].data());
-                    names.push_back(paramType.name());
-                    types.push_back(paramType.iface());
-                }
+    for (int i = 0; i < overload.targetTypes.size(); i++) {
+        QMetaType paramType = method.parameterMetaType(i);
+        if (paramType == QMetaType(QMetaType::Type::QVariant)) {
+            args[i] = QVariant::fromValue(args[i]);
+        }
+        data.push_back(args[i].data());
+        names.push_back(paramType.name());
+        types.push_back(paramType.iface());
+    }
 
-                QMetaMethodInvoker::InvokeFailReason reason =
-                    QMetaMethodInvoker::invokeImpl(method, object, Qt::DirectConnection,
-                                                   data.size(), &data[0], &names[0], &types[0]);
+    QMetaMethodInvoker::InvokeFailReason reason =
+        QMetaMethodInvoker::invokeImpl(method, object, Qt::DirectConnection,
+                                       data.size(), &data[0], &names[0], &types[0]);
 
-                if (int(reason) <= 0) {
-                    return reason == QMetaMethodInvoker::InvokeFailReason::None;
-                } else {
-                    qWarning() << Q_FUNC_INFO << "method not found!";
-                    return false;
-                }
+    if (int(reason) <= 0) {
+        return reason == QMetaMethodInvoker::InvokeFailReason::None;
+    } else {
+        qWarning() << Q_FUNC_INFO << "method not found!";
+        return false;
+    }
 #else
-                QGenericArgument arguments[10] = {QGenericArgument()};
-                for (int i = 0; i < method.parameterCount() && args.count() > i; i++)
-                {
-                    int paramType = method.parameterType(i);
-                    if (paramType == QMetaType::QVariant)
-                    {
-                        arguments[i] = Q_ARG(QVariant, args[i]);
-                    }
-                    else
-                    {
-                        if (paramType != args[i].type() && args[i].canConvert(paramType)) {
-                            args[i].convert(paramType);
-                        }
-                        arguments[i] = qVariantToArgument(args[i]);
-                    }
-                }
-
-                int returnType =  method.returnType();
-                if (returnType == QMetaType::Void) {
-                    return QMetaObject::invokeMethod(object,
-                                                     methodName.toLatin1().constData(),
-                                                     Qt::DirectConnection,
-                                                     arguments[0],
-                                                     arguments[1],
-                                                     arguments[2],
-                                                     arguments[3],
-                                                     arguments[4],
-                                                     arguments[5],
-                                                     arguments[6],
-                                                     arguments[7],
-                                                     arguments[8],
-                                                     arguments[9]);
-                } else {
-                    ret->setValue(QVariant(QVariant::nameToType(QMetaType::typeName(returnType))));
-                    return QMetaObject::invokeMethod(object,
-                                                     methodName.toLatin1().constData(),
-                                                     Qt::DirectConnection,
-                                                     QGenericReturnArgument(ret->typeName(), ret->data()),
-                                                     arguments[0],
-                                                     arguments[1],
-                                                     arguments[2],
-                                                     arguments[3],
-                                                     arguments[4],
-                                                     arguments[5],
-                                                     arguments[6],
-                                                     arguments[7],
-                                                     arguments[8],
-                                                     arguments[9]);
-                }
-#endif
-            }
+    QGenericArgument arguments[10] = {QGenericArgument()};
+    for (int i = 0; i < overload.targetTypes.size() && i < 10; i++)
+    {
+        if (overload.targetTypes.at(i) == QMetaType::QVariant)
+        {
+            arguments[i] = Q_ARG(QVariant, args[i]);
+        }
+        else
+        {
+            arguments[i] = qVariantToArgument(args[i]);
         }
-    } while ((mo = mo->superClass()));
+    }
 
-    if (implemented)
-    {
-        *implemented = false;
+    int returnType =  method.returnType();
+    if (returnType == QMetaType::Void || !ret) {
+        return method.invoke(object,
+                             Qt::DirectConnection,
+                             arguments[0],
+                             arguments[1],
+                             arguments[2],
+                             arguments[3],
+                             arguments[4],
+                             arguments[5],
+                             arguments[6],
+                             arguments[7],
+                             arguments[8],
+                             arguments[9]);
+    } else {
+        ret->setValue(QVariant(QVariant::nameToType(QMetaType::typeName(returnType))));
+        return method.invoke(object,
+                             Qt::DirectConnection,
+                             QGenericReturnArgument(ret->typeName(), ret->data()),
+                             arguments[0],
+                             arguments[1],
+                             arguments[2],
+                             arguments[3],
+                             arguments[4],
+                             arguments[5],
+                             arguments[6],
+                             arguments[7],
+                             arguments[8],
+                             arguments[9]);
     }
-    return false;
+#endif
 }
 
 void QAEngine::addItem(QObject* o)
@@ -559,6 +956,7 @@ void QAEngine::removeItem(QObject* o)
     {
         return;
     }
+    QAHandleTable::remove(o);
     if (auto platform = getPlatform(true))
     {
         platform->removeItem(o);
@@ -569,47 +967,95 @@ void QAEngine::removeItem(QObject* o)
     }
 }
 
-void QAEngine::processCommand(ITransportClient* socket, const QByteArray& cmd)
+void QAEngine::processCommand(ITransportClient* socket, const QACommand& command)
 {
-    qCDebug(categoryEngine) << Q_FUNC_INFO << socket;
-    qCDebug(categoryEngine).noquote() << cmd;
-
-    QJsonParseError error;
-    QJsonDocument json = QJsonDocument::fromJson(cmd, &error);
-    if (error.error != QJsonParseError::NoError)
+    // command queued before clientLost closed the session, the client is gone
+    QASession* session = QASession::find(socket);
+    if (!session)
     {
+        qCDebug(categoryEngine) << Q_FUNC_INFO << socket << command.action << "no session, dropped";
         return;
     }
-
-    auto&& object = json.object();
-
-    if (!object.contains(QStringLiteral("cmd")))
+    connect(session,
+            &QASession::commandReady,
+            this,
+            &QAEngine::processCommand,
+            Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
+
+    // cancel with id must not wait behind a running command without id
+    if (command.action == QLatin1String("cancel") && command.id.isValid())
     {
+        const int cancelled = session->cancel(command.params.value(0));
+        socket->sendReply(command.id, cancelled);
         return;
     }
 
-    if (object.value(QStringLiteral("cmd")).toVariant().toString() != QStringLiteral("action"))
+    if (!session->admitCommand(command))
     {
         return;
     }
 
-    if (!object.contains(QStringLiteral("action")))
+    session->beginDispatch(command);
+    dispatchCommand(socket, session, command);
+    session->endDispatch();
+}
+
+void QAEngine::dispatchCommand(ITransportClient* socket, QASession* session, const QACommand& command)
+{
+    if (command.isExpired())
     {
+        qCDebug(categoryEngine) << Q_FUNC_INFO << socket << command.action << "deadline expired";
+        socket->sendReply(command.id, QStringLiteral("timeout"), QASession::s_timeoutStatus);
         return;
     }
 
-    const auto action = object.value(QStringLiteral("action")).toVariant().toString();
-    const auto params = object.value(QStringLiteral("params")).toVariant().toList();
+    qCDebug(categoryEngine) << Q_FUNC_INFO << socket << command.action
+                            << "queued:" << command.received.elapsed() << "ms";
+    static const QAStats::Key queuedKey = QAStats::key(QStringLiteral("queued"));
+    QAStats::record(queuedKey, command.received.nsecsElapsed());
+
+    const QString& action = command.action;
+    const QVariantList& params = command.params;
+
+    QASession::Scope scope(session);
 
-    if (action == "startAnalyze") {
-        m_analyzeActive = true;
-        m_analyzeSocket = socket;
+    const bool appConnect = action == QLatin1String("appConnect");
+    if (appConnect) {
+        socket->negotiate(params.value(0).toMap());
+    } else if (action == "startAnalyze") {
+        session->setAnalyzeActive(true);
     } else if (action == "stopAnalyze") {
-        m_analyzeActive = false;
-        m_analyzeSocket = nullptr;
+        session->setAnalyzeActive(false);
+    } else if (action == QLatin1String("cancel")) {
+        socket->sendReply(command.id, session->cancel(params.value(0)));
+        return;
+    } else if (action == QLatin1String("batch")) {
+        auto batch = new QABatch(socket,
+                                 command.id,
+                                 params.value(0).toList(),
+                                 params.value(1).toMap(),
+                                 [this](ITransportClient* client,
+                                        const QString& itemAction,
+                                        const QVariantList& itemParams)
+                                 { processAppiumCommand(client, itemAction, itemParams); },
+                                 this);
+        // replies once all items did, the deadline cancels the batch as a whole
+        session->deferReply();
+        session->setCommandDeadline(command.remainingTime());
+        batch->start();
+        session->setCommandDeadline(-1);
+        return;
     }
 
+    session->setCommandDeadline(command.remainingTime());
+    socket->beginRequest(command.id);
     processAppiumCommand(socket, action, params);
+    socket->endRequest();
+    session->setCommandDeadline(-1);
+
+    if (appConnect) {
+        socket->applyNegotiated();
+    }
 }
 
 bool QAEngine::processAppiumCommand(ITransportClient* socket,
@@ -619,6 +1065,10 @@ bool QAEngine::processAppiumCommand(ITransportClient* socket,
     const QString methodName = QStringLiteral("%1Command").arg(action);
     qCDebug(categoryEngine) << Q_FUNC_INFO << socket << methodName << params;
 
+    // dispatch only, asynchronous commands reply later
+    static const QAStats::Key unknownKey = QAStats::key(QStringLiteral("command:unknown"));
+    QAStats::Timer timer(unknownKey);
+
     bool result = false;
     if (auto platform = getPlatform())
     {
@@ -627,21 +1077,24 @@ bool QAEngine::processAppiumCommand(ITransportClient* socket,
         bool implemented = true;
         result = metaInvoke(socket, platform, methodName, params, &implemented);
 
+        if (implemented)
+        {
+            timer.setKey(QStringLiteral("command:") + action);
+        }
+
         if (!implemented)
         {
             platform->socketReply(socket, QStringLiteral("not_implemented"), 405);
         }
+        else if (!result)
+        {
+            // every command gets a reply, commands without id wait for it
+            platform->socketReply(socket, QStringLiteral("invalid_arguments"), 400);
+        }
     }
     else
     {
-        QJsonObject reply;
-        reply.insert(QStringLiteral("status"), 1);
-        reply.insert(QStringLiteral("value"), QStringLiteral("no platform!"));
-
-        const QByteArray data = QJsonDocument(reply).toJson(QJsonDocument::Compact);
-
-        socket->write(data);
-        socket->flush();
+        socket->sendReply(socket->requestId(), QStringLiteral("no platform!"), 1);
     }
 
     return result;
@@ -1,99 +1,250 @@
-#include <qt_qa_engine/QAEngine.h>
+#include <qt_qa_engine/LocalSocketClient.h>
 #include <qt_qa_engine/QAEngineSocketClient.h>
 #include <qt_qa_engine/TCPSocketClient.h>
 
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QFileInfo>
-#include <QHostAddress>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QJsonParseError>
-#include <QLocalSocket>
 #include <QTcpSocket>
+#include <QTimer>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
 
 #include <QLoggingCategory>
 
 Q_LOGGING_CATEGORY(categorySocketClient, "autoqa.qaengine.socket", QtWarningMsg)
 
-QAEngineSocketClient::QAEngineSocketClient(QObject* parent)
-    : QObject(parent)
+QAEngineSocketClient::QAEngineSocketClient(const QString& endpoint,
+                                           int heartbeatInterval,
+                                           int silenceTimeout,
+                                           QObject* parent)
+    : ITransportServer(parent)
+    , m_endpoint(endpoint)
+    , m_reconnectTimer(new QTimer(this))
+    , m_connectTimer(new QTimer(this))
+    , m_heartbeatTimer(new QTimer(this))
+    , m_silenceTimer(new QTimer(this))
 {
+    const int colon = endpoint.lastIndexOf(QLatin1Char(':'));
+    bool isTcp = false;
+    if (colon > 0)
+    {
+        m_port = endpoint.mid(colon + 1).toUShort(&isTcp);
+        m_host = endpoint.left(colon);
+    }
+
+    if (isTcp)
+    {
+        auto socket = new QTcpSocket(this);
+        connect(socket,
+                &QAbstractSocket::stateChanged,
+                this,
+                &QAEngineSocketClient::onTcpStateChanged);
+        m_tcpSocket = socket;
+        m_client = new TCPSocketClient(socket, this);
+    }
+    else
+    {
+        m_localSocket = new QLocalSocket(this);
+        connect(m_localSocket,
+                &QLocalSocket::stateChanged,
+                this,
+                &QAEngineSocketClient::onLocalStateChanged);
+        m_client = new LocalSocketClient(m_localSocket, this);
+    }
+    // one client object serves all reconnects, engine sees every disconnect as lost client
+    registerClient(m_client);
+
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &QAEngineSocketClient::connectToBridge);
+
+    m_connectTimer->setSingleShot(true);
+    m_connectTimer->setInterval(s_connectTimeout);
+    connect(m_connectTimer,
+            &QTimer::timeout,
+            this,
+            [this]()
+            {
+                qCWarning(categorySocketClient) << Q_FUNC_INFO << m_endpoint << "connect timeout";
+                abortConnection();
+            });
+
+    m_heartbeatTimer->setInterval(heartbeatInterval);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &QAEngineSocketClient::sendHeartbeat);
+
+    m_silenceTimer->setSingleShot(true);
+    m_silenceTimer->setInterval(silenceTimeout);
+    connect(m_silenceTimer, &QTimer::timeout, this, &QAEngineSocketClient::onSilenceTimeout);
+}
+
+void QAEngineSocketClient::readData(ITransportClient* client)
+{
+    if (m_silenceTimer->interval() > 0)
+    {
+        m_silenceTimer->start();
+    }
+    ITransportServer::readData(client);
+}
+
+void QAEngineSocketClient::start()
+{
+    qCDebug(categorySocketClient) << Q_FUNC_INFO << m_endpoint;
+
+    connectToBridge();
 }
 
 void QAEngineSocketClient::connectToBridge()
 {
-    qCDebug(categorySocketClient) << Q_FUNC_INFO;
+    qCDebug(categorySocketClient) << Q_FUNC_INFO << m_endpoint << "retry delay:" << m_retryDelay;
 
-    auto socket = new QTcpSocket(this);
-    socket->connectToHost(QHostAddress(QHostAddress::LocalHost), 8888);
-    m_client = new TCPSocketClient(socket, this);
+    m_reconnectTimer->stop();
+    m_connectTimer->start();
+    if (m_tcpSocket)
+    {
+        if (m_tcpSocket->state() == QAbstractSocket::UnconnectedState)
+        {
+            m_tcpSocket->connectToHost(m_host, m_port);
+        }
+    }
+    else if (m_localSocket->state() == QLocalSocket::UnconnectedState)
+    {
+        m_localSocket->connectToServer(m_endpoint);
+    }
+}
 
-    if (!m_client->isConnected())
+void QAEngineSocketClient::onTcpStateChanged(QAbstractSocket::SocketState state)
+{
+    if (state == QAbstractSocket::ConnectedState)
     {
-        qCDebug(categorySocketClient) << Q_FUNC_INFO << m_client << "is not connected!";
-        return;
+        m_tcpSocket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+        m_tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        onConnected();
+    }
+    else if (state == QAbstractSocket::UnconnectedState)
+    {
+        onUnconnected();
+    }
+}
+
+void QAEngineSocketClient::onLocalStateChanged(QLocalSocket::LocalSocketState state)
+{
+    if (state == QLocalSocket::ConnectedState)
+    {
+        onConnected();
+    }
+    else if (state == QLocalSocket::UnconnectedState)
+    {
+        onUnconnected();
     }
+}
+
+void QAEngineSocketClient::onConnected()
+{
+    qCDebug(categorySocketClient) << Q_FUNC_INFO << m_endpoint;
+
+    m_connectTimer->stop();
+    m_connected = true;
+    m_retryDelay = s_minRetryDelay;
+    m_client->resetConnection();
+    emit clientAdded(m_client);
 
-    QJsonObject root;
     QJsonObject app;
-    app.insert(QStringLiteral("appName"), QAEngine::processName());
+    app.insert(QStringLiteral("appName"),
+               QFileInfo(QCoreApplication::applicationFilePath()).baseName());
+    app.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
 
+    QJsonObject root;
     root.insert(QStringLiteral("appConnect"), app);
+    m_client->writeFrame(QJsonDocument(root).toJson(QJsonDocument::Compact));
 
-    QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
-    auto bytes = m_client->write(data);
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << "Bytes to write:" << bytes;
-    auto success = m_client->waitForBytesWritten();
-    qCDebug(categorySocketClient) << "Writing to bridge socket:" << success;
+    if (m_heartbeatTimer->interval() > 0)
+    {
+        m_heartbeatTimer->start();
+    }
+    if (m_silenceTimer->interval() > 0)
+    {
+        m_silenceTimer->start();
+    }
+}
 
-    connect(m_client,
-            &ITransportClient::readyRead,
-            this,
-            &QAEngineSocketClient::readClient,
-            Qt::UniqueConnection);
+void QAEngineSocketClient::onUnconnected()
+{
+    m_connectTimer->stop();
+    m_heartbeatTimer->stop();
+    m_silenceTimer->stop();
+    if (m_connected)
+    {
+        qCWarning(categorySocketClient) << Q_FUNC_INFO << m_endpoint << "connection lost";
+        m_connected = false;
+    }
+    scheduleReconnect();
 }
 
-void QAEngineSocketClient::readClient(ITransportClient* client)
+void QAEngineSocketClient::sendHeartbeat()
 {
-    auto bytes = client->bytesAvailable();
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << client << bytes;
+    if (!m_connected)
+    {
+        return;
+    }
+
+    if (m_client->isBackpressured())
+    {
+        // data is flowing anyway, or the link is gone
+        return;
+    }
 
-    emit commandReceived(client, client->readAll());
+    QJsonObject root;
+    root.insert(QStringLiteral("heartbeat"), QDateTime::currentMSecsSinceEpoch());
+    m_client->writeFrame(QJsonDocument(root).toJson(QJsonDocument::Compact));
 }
 
-void QAEngineSocketClient::onConnected()
+void QAEngineSocketClient::onSilenceTimeout()
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << Qt::endl
-                                  << "client:" << m_client << Qt::endl
-#else
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << endl
-                                  << "client:" << m_client << endl
-#endif
-                                  << "is connected:" << m_client->isConnected();
+    if (!m_connected)
+    {
+        return;
+    }
 
-    QJsonObject root;
-    QJsonObject app;
-    app.insert(QStringLiteral("appName"), QAEngine::processName());
+    // half-open connection never reports an error, only a bridge answering heartbeats
+    // lets silence tell it apart from an idle one
+    qCWarning(categorySocketClient) << Q_FUNC_INFO << m_endpoint << "no data for"
+                                    << m_silenceTimer->interval() << "ms";
+    abortConnection();
+}
 
-    root.insert(QStringLiteral("appConnect"), app);
+void QAEngineSocketClient::abortConnection()
+{
+    if (m_tcpSocket)
+    {
+        m_tcpSocket->abort();
+    }
+    else
+    {
+        m_localSocket->abort();
+    }
+}
 
-    QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
-    auto bytes = m_client->write(data);
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << "Bytes to write:" << bytes;
-    auto success = m_client->waitForBytesWritten();
-    qCDebug(categorySocketClient) << "Writing to bridge socket:" << success;
+void QAEngineSocketClient::scheduleReconnect()
+{
+    if (m_reconnectTimer->isActive())
+    {
+        return;
+    }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << Qt::endl
-                                  << "ready read:" << m_client->waitForReadyRead() << Qt::endl;
+    // random half of the delay spreads reconnects of many apps restarted together
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    const int jitter = int(QRandomGenerator::global()->bounded(m_retryDelay / 2 + 1));
 #else
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << endl
-                                  << "ready read:" << m_client->waitForReadyRead() << endl;
+    const int jitter = qrand() % (m_retryDelay / 2 + 1);
 #endif
+    const int delay = m_retryDelay / 2 + jitter;
+    m_retryDelay = qMin(m_retryDelay * 2, int(s_maxRetryDelay));
 
-    auto available = m_client->bytesAvailable();
-    qCDebug(categorySocketClient) << Q_FUNC_INFO << m_client << available;
-
-    qCDebug(categorySocketClient).noquote() << m_client->readAll();
+    qCDebug(categorySocketClient) << Q_FUNC_INFO << m_endpoint << "reconnect in" << delay << "ms";
+    m_reconnectTimer->start(delay);
 }
@@ -0,0 +1,200 @@
+#include <qt_qa_engine/QAFrameDecoder.h>
+
+#include <QtEndian>
+
+#include <cstring>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryFrameDecoder, "autoqa.qaengine.transport.decoder", QtWarningMsg)
+
+QAFrameDecoder::Mode QAFrameDecoder::mode() const
+{
+    return m_mode;
+}
+
+void QAFrameDecoder::setMode(QAFrameDecoder::Mode mode)
+{
+    m_mode = mode;
+    m_scan = m_offset;
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+}
+
+void QAFrameDecoder::append(const QByteArray& data)
+{
+    if (m_offset > 0 && m_offset >= m_buffer.size() / 2)
+    {
+        m_buffer.remove(0, m_offset);
+        m_scan -= m_offset;
+        m_offset = 0;
+    }
+    m_buffer.append(data);
+}
+
+bool QAFrameDecoder::takeFrame(QByteArray* frame)
+{
+    if (m_error)
+    {
+        return false;
+    }
+
+    switch (m_mode)
+    {
+        case LengthPrefixedMode:
+            return takeLengthPrefixedFrame(frame);
+        case JsonMode:
+        default:
+            return takeJsonFrame(frame);
+    }
+}
+
+bool QAFrameDecoder::hasError() const
+{
+    return m_error;
+}
+
+int QAFrameDecoder::bufferedBytes() const
+{
+    return m_buffer.size() - m_offset;
+}
+
+void QAFrameDecoder::clear()
+{
+    m_buffer.clear();
+    m_offset = 0;
+    m_error = false;
+    m_scan = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+}
+
+QByteArray QAFrameDecoder::encodeFrame(const QByteArray& payload,
+                                       QAFrameDecoder::Mode mode,
+                                       bool compressed)
+{
+    if (mode != LengthPrefixedMode)
+    {
+        return payload;
+    }
+
+    QByteArray frame(s_headerSize + payload.size(), Qt::Uninitialized);
+    const quint32 header = quint32(payload.size()) | (compressed ? s_compressedFlag : 0u);
+    qToBigEndian<quint32>(header, reinterpret_cast<uchar*>(frame.data()));
+    memcpy(frame.data() + s_headerSize, payload.constData(), payload.size());
+    return frame;
+}
+
+bool QAFrameDecoder::takeJsonFrame(QByteArray* frame)
+{
+    // every byte is inspected once: scanner keeps its state between calls
+    const char* data = m_buffer.constData();
+    const int size = m_buffer.size();
+    while (m_scan < size)
+    {
+        const char c = data[m_scan++];
+        if (m_inString)
+        {
+            if (m_escape)
+            {
+                m_escape = false;
+            }
+            else if (c == '\\')
+            {
+                m_escape = true;
+            }
+            else if (c == '"')
+            {
+                m_inString = false;
+            }
+            continue;
+        }
+
+        switch (c)
+        {
+            case '"':
+                m_inString = m_depth > 0;
+                break;
+            case '{':
+            case '[':
+                if (m_depth == 0)
+                {
+                    // skip separators and garbage between commands
+                    m_offset = m_scan - 1;
+                }
+                m_depth++;
+                break;
+            case '}':
+            case ']':
+                if (m_depth == 0)
+                {
+                    qCDebug(categoryFrameDecoder) << Q_FUNC_INFO << "Unbalanced bracket, skipping";
+                    break;
+                }
+                if (--m_depth == 0)
+                {
+                    *frame = m_buffer.mid(m_offset, m_scan - m_offset);
+                    consume(m_scan - m_offset);
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (m_depth == 0)
+    {
+        // nothing but separators left
+        consume(m_scan - m_offset);
+    }
+    else if (static_cast<quint32>(m_scan - m_offset) > s_maxFrameSize)
+    {
+        qCWarning(categoryFrameDecoder) << Q_FUNC_INFO << "Frame is too big:" << m_scan - m_offset;
+        m_error = true;
+    }
+    return false;
+}
+
+bool QAFrameDecoder::takeLengthPrefixedFrame(QByteArray* frame)
+{
+    if (bufferedBytes() < s_headerSize)
+    {
+        return false;
+    }
+
+    const quint32 size =
+        qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(m_buffer.constData() + m_offset));
+    if (size > s_maxFrameSize)
+    {
+        qCWarning(categoryFrameDecoder) << Q_FUNC_INFO << "Frame is too big:" << size;
+        m_error = true;
+        return false;
+    }
+
+    if (bufferedBytes() < s_headerSize + static_cast<int>(size))
+    {
+        return false;
+    }
+
+    *frame = m_buffer.mid(m_offset + s_headerSize, size);
+    consume(s_headerSize + size);
+    return true;
+}
+
+void QAFrameDecoder::consume(int bytes)
+{
+    m_offset += bytes;
+    if (m_scan < m_offset)
+    {
+        m_scan = m_offset;
+    }
+    if (m_offset >= m_buffer.size())
+    {
+        m_buffer.clear();
+        m_offset = 0;
+        m_scan = 0;
+    }
+}
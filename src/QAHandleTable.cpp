@@ -0,0 +1,146 @@
+#include <qt_qa_engine/GenericEnginePlatform.h>
+#include <qt_qa_engine/QAEngine.h>
+#include <qt_qa_engine/QAHandleTable.h>
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryHandleTable, "autoqa.qaengine.handles", QtWarningMsg)
+
+namespace
+{
+
+struct Slot
+{
+    QObject* object = nullptr;
+    quint32 generation = 1;
+    QString id;
+};
+
+QVector<Slot> s_slots;
+QVector<quint32> s_freeSlots;
+QHash<QObject*, quint32> s_objectSlots;
+
+// objects may move to and die on other threads whatever thread they were created on
+QAtomicInt s_handleCount;
+
+const QLatin1String s_separator("_0x");
+
+} // namespace
+
+QString QAHandleTable::id(QObject* object)
+{
+    if (!object)
+    {
+        return QString();
+    }
+
+    // slot of an object destroyed on another thread at the same address must be freed first
+    QAEngine::flushRemovedObjects();
+
+    auto existing = s_objectSlots.constFind(object);
+    if (existing != s_objectSlots.constEnd())
+    {
+        return s_slots.at(int(existing.value())).id;
+    }
+
+    quint32 index = 0;
+    if (!s_freeSlots.isEmpty())
+    {
+        index = s_freeSlots.takeLast();
+    }
+    else
+    {
+        index = quint32(s_slots.size());
+        s_slots.append(Slot());
+    }
+
+    Slot& slot = s_slots[int(index)];
+    slot.object = object;
+    s_handleCount.ref();
+    const quint64 handle = (quint64(slot.generation) << 32) | index;
+    slot.id = GenericEnginePlatform::getClassName(object) + s_separator
+              + QString::number(handle, 16).rightJustified(16, QLatin1Char('0'));
+    s_objectSlots.insert(object, index);
+
+    qCDebug(categoryHandleTable) << Q_FUNC_INFO << object << slot.id;
+    return slot.id;
+}
+
+QObject* QAHandleTable::object(const QString& id)
+{
+    QAEngine::flushRemovedObjects();
+
+    bool ok = false;
+    const quint64 value = handle(id, &ok);
+    if (!ok)
+    {
+        return nullptr;
+    }
+
+    const quint32 index = quint32(value & 0xffffffffu);
+    const quint32 generation = quint32(value >> 32);
+    if (index >= quint32(s_slots.size()))
+    {
+        return nullptr;
+    }
+
+    const Slot& slot = s_slots.at(int(index));
+    if (!slot.object || slot.generation != generation || slot.id != id)
+    {
+        qCDebug(categoryHandleTable) << Q_FUNC_INFO << "Stale handle:" << id;
+        return nullptr;
+    }
+    return slot.object;
+}
+
+void QAHandleTable::remove(QObject* object)
+{
+    auto existing = s_objectSlots.find(object);
+    if (existing == s_objectSlots.end())
+    {
+        return;
+    }
+
+    const quint32 index = existing.value();
+    s_objectSlots.erase(existing);
+
+    Slot& slot = s_slots[int(index)];
+    s_handleCount.deref();
+    slot.object = nullptr;
+    slot.id.clear();
+    slot.generation++;
+    if (slot.generation == 0)
+    {
+        slot.generation = 1;
+    }
+    s_freeSlots.append(index);
+}
+
+int QAHandleTable::count()
+{
+    return s_objectSlots.size();
+}
+
+bool QAHandleTable::hasHandles()
+{
+    return s_handleCount.loadAcquire() > 0;
+}
+
+quint64 QAHandleTable::handle(const QString& id, bool* ok)
+{
+    const int separator = id.lastIndexOf(s_separator);
+    if (separator < 0)
+    {
+        if (ok)
+        {
+            *ok = false;
+        }
+        return 0;
+    }
+    return id.mid(separator + s_separator.size()).toULongLong(ok, 16);
+}
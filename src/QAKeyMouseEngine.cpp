@@ -2,8 +2,10 @@
 #include <qt_qa_engine/QAEngine.h>
 #include <qt_qa_engine/QAKeyMouseEngine.h>
 #include <qt_qa_engine/QAPendingEvent.h>
+#include <qt_qa_engine/QATrace.h>
 
 #include <QCoreApplication>
+#include <QEventLoop>
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QTimer>
@@ -109,6 +111,16 @@ int seleniumKeyToQt(ushort key)
     return seleniumKeys[key];
 }
 
+// desktop window managers need a moment before synthesized input reaches the window
+int inputStartDelay()
+{
+#if (!defined(MO_OS_ANDROID) && !defined(MO_OS_IOS))
+    return 100;
+#else
+    return 0;
+#endif
+}
+
 } // namespace
 
 QAKeyMouseEngine::QAKeyMouseEngine(QObject* parent)
@@ -316,93 +328,113 @@ QAPendingEvent* QAKeyMouseEngine::move(
     return performTouchAction(action);
 }
 
-void QAKeyMouseEngine::pressEnter()
+QAPendingEvent* QAKeyMouseEngine::pressEnter()
 {
-#if (!defined(MO_OS_ANDROID) && !defined(MO_OS_IOS))
-    // QAEngine::instance()->getPlatform()->activateWindow();
-
-    QEventLoop loop;
-    QTimer::singleShot(100, &loop, &QEventLoop::quit);
-    loop.exec();
-#endif
-
-    sendKeyPress('\n', Qt::Key_Return);
-    sendKeyRelease('\n', Qt::Key_Return);
+    QAPendingEvent* event = new QAPendingEvent(this);
+    connect(event, &QAPendingEvent::completed, event, &QObject::deleteLater);
+    QTimer::singleShot(inputStartDelay(),
+                       event,
+                       [this, event]()
+                       {
+                           if (event->isCancelled())
+                           {
+                               return;
+                           }
+                           sendKeyPress('\n', Qt::Key_Return);
+                           sendKeyRelease('\n', Qt::Key_Return);
+                           event->setCompleted();
+                       });
+    return event;
 }
 
 QAPendingEvent* QAKeyMouseEngine::performMultiAction(const QVariantList& multiActions)
 {
-#if (!defined(MO_OS_ANDROID) && !defined(MO_OS_IOS))
-    // QAEngine::instance()->getPlatform()->activateWindow();
-
-    QEventLoop loop;
-    QTimer::singleShot(100, &loop, &QEventLoop::quit);
-    loop.exec();
-#endif
-
     QAPendingEvent* event = new QAPendingEvent(this);
     event->setProperty("finishedCount", 0);
-    QReadWriteLock* lock = new QReadWriteLock();
+    const EventWorkerElements elements = EventWorker::ResolveElements(QVariant(multiActions));
 
-    const int actionsSize = multiActions.size();
-    for (const QVariant& multiActionVar : multiActions)
-    {
-        const QVariantList actions = multiActionVar.toList();
-
-        EventWorker* worker = EventWorker::PerformTouchAction(actions);
-        connect(worker, &EventWorker::pressed, this, &QAKeyMouseEngine::onPressed);
-        connect(worker, &EventWorker::moved, this, &QAKeyMouseEngine::onMoved);
-        connect(worker, &EventWorker::released, this, &QAKeyMouseEngine::onReleased);
-        connect(worker,
-                &EventWorker::finished,
-                event,
-                [lock, event, actionsSize]()
-                {
-                    lock->lockForWrite();
-                    int finishedCount = event->property("finishedCount").toInt();
-                    event->setProperty("finishedCount", ++finishedCount);
-                    lock->unlock();
-                    if (finishedCount == actionsSize)
-                    {
-                        QMetaObject::invokeMethod(event, "setCompleted", Qt::QueuedConnection);
-                        event->deleteLater();
-                        delete lock;
-                    }
-                });
-    }
+    // workers start from the event loop, the caller gets the pending event right away
+    QTimer::singleShot(
+        inputStartDelay(),
+        event,
+        [this, event, multiActions, elements]()
+        {
+            if (event->isCancelled())
+            {
+                event->deleteLater();
+                return;
+            }
 
-    if (m_mode == TouchEventMode)
-    {
-        m_touchPoints.clear();
-    }
+            QReadWriteLock* lock = new QReadWriteLock();
+
+            const int actionsSize = multiActions.size();
+            for (const QVariant& multiActionVar : multiActions)
+            {
+                const QVariantList actions = multiActionVar.toList();
+
+                EventWorker* worker = EventWorker::PerformTouchAction(actions, elements);
+                connect(worker, &EventWorker::pressed, this, &QAKeyMouseEngine::onPressed);
+                connect(worker, &EventWorker::moved, this, &QAKeyMouseEngine::onMoved);
+                connect(worker, &EventWorker::released, this, &QAKeyMouseEngine::onReleased);
+                connect(event, &QAPendingEvent::cancelled, worker, &EventWorker::stop);
+                connect(worker,
+                        &EventWorker::finished,
+                        event,
+                        [lock, event, actionsSize]()
+                        {
+                            lock->lockForWrite();
+                            int finishedCount = event->property("finishedCount").toInt();
+                            event->setProperty("finishedCount", ++finishedCount);
+                            lock->unlock();
+                            if (finishedCount == actionsSize)
+                            {
+                                QMetaObject::invokeMethod(
+                                    event, "setCompleted", Qt::QueuedConnection);
+                                event->deleteLater();
+                                delete lock;
+                            }
+                        });
+            }
+
+            if (m_mode == TouchEventMode)
+            {
+                m_touchPoints.clear();
+            }
+        });
 
     return event;
 }
 
 QAPendingEvent* QAKeyMouseEngine::performTouchAction(const QVariantList& actions)
 {
-#if (!defined(MO_OS_ANDROID) && !defined(MO_OS_IOS))
-    // QAEngine::instance()->getPlatform()->activateWindow();
-
-    QEventLoop loop;
-    QTimer::singleShot(100, &loop, &QEventLoop::quit);
-    loop.exec();
-#endif
-
     QAPendingEvent* event = new QAPendingEvent(this);
-    EventWorker* worker = EventWorker::PerformTouchAction(actions);
-    connect(worker, &EventWorker::pressed, this, &QAKeyMouseEngine::onPressed);
-    connect(worker, &EventWorker::moved, this, &QAKeyMouseEngine::onMoved);
-    connect(worker, &EventWorker::released, this, &QAKeyMouseEngine::onReleased);
-    connect(worker,
-            &EventWorker::finished,
-            event,
-            [event]()
+    const EventWorkerElements elements = EventWorker::ResolveElements(QVariant(actions));
+    QTimer::singleShot(
+        inputStartDelay(),
+        event,
+        [this, event, actions, elements]()
+        {
+            if (event->isCancelled())
             {
-                qDebug() << Q_FUNC_INFO << "event finished";
-                QMetaObject::invokeMethod(event, "setCompleted", Qt::QueuedConnection);
                 event->deleteLater();
-            });
+                return;
+            }
+
+            EventWorker* worker = EventWorker::PerformTouchAction(actions, elements);
+            connect(worker, &EventWorker::pressed, this, &QAKeyMouseEngine::onPressed);
+            connect(worker, &EventWorker::moved, this, &QAKeyMouseEngine::onMoved);
+            connect(worker, &EventWorker::released, this, &QAKeyMouseEngine::onReleased);
+            connect(event, &QAPendingEvent::cancelled, worker, &EventWorker::stop);
+            connect(worker,
+                    &EventWorker::finished,
+                    event,
+                    [event]()
+                    {
+                        qDebug() << Q_FUNC_INFO << "event finished";
+                        QMetaObject::invokeMethod(event, "setCompleted", Qt::QueuedConnection);
+                        event->deleteLater();
+                    });
+        });
 
     return event;
 }
@@ -410,32 +442,39 @@ QAPendingEvent* QAKeyMouseEngine::performTouchAction(const QVariantList& actions
 QAPendingEvent* QAKeyMouseEngine::performChainActions(const QVariantList& actions)
 {
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << actions;
-#if (!defined(MO_OS_ANDROID) && !defined(MO_OS_IOS))
-    // QAEngine::instance()->getPlatform()->activateWindow();
-
-    QEventLoop loop;
-    QTimer::singleShot(100, &loop, &QEventLoop::quit);
-    loop.exec();
-#endif
 
     QAPendingEvent* event = new QAPendingEvent(this);
-    EventWorker* worker = EventWorker::PerformChainAction(actions);
-    connect(worker, &EventWorker::keyPressed, this, &QAKeyMouseEngine::onKeyPressed);
-    connect(worker, &EventWorker::keyReleased, this, &QAKeyMouseEngine::onKeyReleased);
-    connect(worker, &EventWorker::mousePressed, this, &QAKeyMouseEngine::onMousePressed);
-    connect(worker, &EventWorker::mouseReleased, this, &QAKeyMouseEngine::onMouseReleased);
-    connect(worker, &EventWorker::mouseMoved, this, &QAKeyMouseEngine::onMouseMoved);
-    connect(worker, &EventWorker::mouseWheeled, this, &QAKeyMouseEngine::onMouseWheeled);
-    connect(worker,
-            &EventWorker::finished,
-            this,
-            [event]()
+    const EventWorkerElements elements = EventWorker::ResolveElements(QVariant(actions));
+    QTimer::singleShot(
+        inputStartDelay(),
+        event,
+        [this, event, actions, elements]()
+        {
+            if (event->isCancelled())
             {
-                qDebug() << Q_FUNC_INFO << "0 event finished";
-                QMetaObject::invokeMethod(event, "setCompleted", Qt::QueuedConnection);
                 event->deleteLater();
-                qDebug() << Q_FUNC_INFO << event << "1 event finished";
-            });
+                return;
+            }
+
+            EventWorker* worker = EventWorker::PerformChainAction(actions, elements);
+            connect(worker, &EventWorker::keyPressed, this, &QAKeyMouseEngine::onKeyPressed);
+            connect(worker, &EventWorker::keyReleased, this, &QAKeyMouseEngine::onKeyReleased);
+            connect(worker, &EventWorker::mousePressed, this, &QAKeyMouseEngine::onMousePressed);
+            connect(worker, &EventWorker::mouseReleased, this, &QAKeyMouseEngine::onMouseReleased);
+            connect(worker, &EventWorker::mouseMoved, this, &QAKeyMouseEngine::onMouseMoved);
+            connect(worker, &EventWorker::mouseWheeled, this, &QAKeyMouseEngine::onMouseWheeled);
+            connect(event, &QAPendingEvent::cancelled, worker, &EventWorker::stop);
+            connect(worker,
+                    &EventWorker::finished,
+                    this,
+                    [event]()
+                    {
+                        qDebug() << Q_FUNC_INFO << "0 event finished";
+                        QMetaObject::invokeMethod(event, "setCompleted", Qt::QueuedConnection);
+                        event->deleteLater();
+                        qDebug() << Q_FUNC_INFO << event << "1 event finished";
+                    });
+        });
 
     return event;
 }
@@ -463,6 +502,7 @@ QAKeyMouseEngine::getTouchDevice()
 
 void QAKeyMouseEngine::onPressed(const QPointF point)
 {
+    QATrace::Span span("input:pressed");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -539,6 +579,7 @@ void QAKeyMouseEngine::onPressed(const QPointF point)
 
 void QAKeyMouseEngine::onMoved(const QPointF point)
 {
+    QATrace::Span span("input:moved");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -607,6 +648,7 @@ void QAKeyMouseEngine::onMoved(const QPointF point)
 
 void QAKeyMouseEngine::onReleased(const QPointF point)
 {
+    QATrace::Span span("input:released");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -694,16 +736,19 @@ void QAKeyMouseEngine::sendKeyRelease(const QChar& text, int key)
 
 void QAKeyMouseEngine::onKeyPressed(const QString &value)
 {
+    QATrace::Span span("input:keyPressed");
     handleKey(value, false);
 }
 
 void QAKeyMouseEngine::onKeyReleased(const QString &value)
 {
+    QATrace::Span span("input:keyReleased");
     handleKey(value, true);
 }
 
 void QAKeyMouseEngine::onMousePressed(const QPointF &point, int button)
 {
+    QATrace::Span span("input:mousePressed");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -788,6 +833,7 @@ void QAKeyMouseEngine::onMousePressed(const QPointF &point, int button)
 
 void QAKeyMouseEngine::onMouseReleased(const QPointF &point, int button)
 {
+    QATrace::Span span("input:mouseReleased");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -866,6 +912,7 @@ void QAKeyMouseEngine::onMouseReleased(const QPointF &point, int button)
 
 void QAKeyMouseEngine::onMouseMoved(const QPointF &point)
 {
+    QATrace::Span span("input:mouseMoved");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << point;
     if (m_mode == TouchEventMode)
     {
@@ -935,6 +982,7 @@ void QAKeyMouseEngine::onMouseMoved(const QPointF &point)
 
 void QAKeyMouseEngine::onMouseWheeled(const QPointF &delta, const QPointF &point)
 {
+    QATrace::Span span("input:mouseWheeled");
     qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO << delta;
     if (m_mode == TouchEventMode)
     {
@@ -1004,9 +1052,10 @@ void QAKeyMouseEngine::handleKey(const QString &value, bool keyUp)
     emit keyEvent(event);
 }
 
-EventWorker::EventWorker(const QVariantList& actions)
+EventWorker::EventWorker(const QVariantList& actions, const EventWorkerElements& elements)
     : QObject(nullptr)
     , m_actions(actions)
+    , m_elements(elements)
 {
 }
 
@@ -1014,9 +1063,38 @@ EventWorker::~EventWorker()
 {
 }
 
-EventWorker* EventWorker::PerformTouchAction(const QVariantList& actions)
+void EventWorker::stop()
+{
+    qCDebug(categoryKeyMouseEngine) << Q_FUNC_INFO;
+
+    m_stopped = true;
+    if (m_wait)
+    {
+        m_wait->quit();
+    }
+}
+
+bool EventWorker::wait(int msecs)
 {
-    EventWorker* worker = new EventWorker(actions);
+    if (m_stopped)
+    {
+        return false;
+    }
+
+    // stop() arrives as a queued call and is handled by this loop
+    QATrace::Span span("input:wait");
+    QEventLoop loop;
+    m_wait = &loop;
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+    m_wait = nullptr;
+    return !m_stopped;
+}
+
+EventWorker* EventWorker::PerformTouchAction(const QVariantList& actions,
+                                             const EventWorkerElements& elements)
+{
+    EventWorker* worker = new EventWorker(actions, elements);
     QThread* thread = new QThread;
     connect(thread, &QThread::started, worker, &EventWorker::start);
     connect(worker, &EventWorker::finished, thread, &QThread::quit);
@@ -1027,9 +1105,10 @@ EventWorker* EventWorker::PerformTouchAction(const QVariantList& actions)
     return worker;
 }
 
-EventWorker *EventWorker::PerformChainAction(const QVariantList &actions)
+EventWorker *EventWorker::PerformChainAction(const QVariantList &actions,
+                                             const EventWorkerElements& elements)
 {
-    EventWorker* worker = new EventWorker(actions);
+    EventWorker* worker = new EventWorker(actions, elements);
     QThread* thread = new QThread;
     connect(thread, &QThread::started, worker, &EventWorker::startChain);
     connect(worker, &EventWorker::finished, thread, &QThread::quit);
@@ -1040,12 +1119,66 @@ EventWorker *EventWorker::PerformChainAction(const QVariantList &actions)
     return worker;
 }
 
+EventWorkerElements EventWorker::ResolveElements(const QVariant& actions)
+{
+    EventWorkerElements elements;
+    auto platform = QAEngine::instance()->getPlatform();
+
+    auto resolve = [&elements, platform](const QString& elementId)
+    {
+        if (!elementId.isEmpty() && !elements.contains(elementId))
+        {
+            elements.insert(elementId, platform->getObject(elementId));
+        }
+    };
+
+    if (actions.userType() == QMetaType::QVariantList)
+    {
+        for (const QVariant& action : actions.toList())
+        {
+            elements.unite(ResolveElements(action));
+        }
+    }
+    else if (actions.userType() == QMetaType::QVariantMap)
+    {
+        const QVariantMap map = actions.toMap();
+        resolve(map.value(QStringLiteral("options")).toMap().value(QStringLiteral("element")).toString());
+
+        const QVariant origin = map.value(QStringLiteral("origin"));
+        const QVariantMap originMap = origin.toMap();
+        resolve(originMap.isEmpty() ? origin.toString()
+                                    : originMap.value(originMap.firstKey()).toString());
+
+        if (map.contains(QStringLiteral("actions")))
+        {
+            elements.unite(ResolveElements(map.value(QStringLiteral("actions"))));
+        }
+    }
+    return elements;
+}
+
+QPointF EventWorker::elementCenter(const QString& elementId, const QPointF& fallback) const
+{
+    QPointer<QObject> item = m_elements.value(elementId);
+    if (!item)
+    {
+        return fallback;
+    }
+    return QAEngine::instance()->getPlatform()->getAbsGeometry(item).center();
+}
+
 void EventWorker::start()
 {
     QPointF previousPoint;
+    bool pointerDown = false;
 
     for (const QVariant& actionVar : m_actions)
     {
+        if (m_stopped)
+        {
+            break;
+        }
+
         const QVariantMap actionMap = actionVar.toMap();
         const QString action = actionMap.value(QStringLiteral("action")).toString();
         const QVariantMap options = actionMap.value(QStringLiteral("options")).toMap();
@@ -1053,9 +1186,7 @@ void EventWorker::start()
         if (action == QLatin1String("wait"))
         {
             const int delay = options.value(QStringLiteral("ms")).toInt();
-            QEventLoop loop;
-            QTimer::singleShot(delay, &loop, &QEventLoop::quit);
-            loop.exec();
+            wait(delay);
         }
         else if (action == QLatin1String("longPress"))
         {
@@ -1065,21 +1196,16 @@ void EventWorker::start()
 
             if (options.contains(QStringLiteral("element")))
             {
-                auto platform = QAEngine::instance()->getPlatform();
-                if (auto item =
-                        platform->getObject(options.value(QStringLiteral("element")).toString()))
-                {
-                    point = platform->getAbsGeometry(item).center();
-                }
+                point = elementCenter(options.value(QStringLiteral("element")).toString(), point)
+                            .toPoint();
             }
 
             sendPress(point);
+            pointerDown = true;
             previousPoint = point;
 
             const int delay = options.value(QStringLiteral("duration")).toInt();
-            QEventLoop loop;
-            QTimer::singleShot(delay, &loop, &QEventLoop::quit);
-            loop.exec();
+            wait(delay);
         }
         else if (action == QLatin1String("press"))
         {
@@ -1089,15 +1215,12 @@ void EventWorker::start()
 
             if (options.contains(QStringLiteral("element")))
             {
-                auto platform = QAEngine::instance()->getPlatform();
-                if (auto item =
-                        platform->getObject(options.value(QStringLiteral("element")).toString()))
-                {
-                    point = platform->getAbsGeometry(item).center();
-                }
+                point = elementCenter(options.value(QStringLiteral("element")).toString(), point)
+                            .toPoint();
             }
 
             sendPress(point);
+            pointerDown = true;
             previousPoint = point;
         }
         else if (action == QLatin1String("moveTo"))
@@ -1108,12 +1231,8 @@ void EventWorker::start()
 
             if (options.contains(QStringLiteral("element")))
             {
-                auto platform = QAEngine::instance()->getPlatform();
-                if (auto item =
-                        platform->getObject(options.value(QStringLiteral("element")).toString()))
-                {
-                    point = platform->getAbsGeometry(item).center();
-                }
+                point = elementCenter(options.value(QStringLiteral("element")).toString(), point)
+                            .toPoint();
             }
 
             const int duration = options.value(QStringLiteral("duration"), 500).toInt();
@@ -1132,6 +1251,7 @@ void EventWorker::start()
                 point = QPointF(posX, posY);
             }
             sendRelease(point);
+            pointerDown = false;
         }
         else if (action == QLatin1String("tap"))
         {
@@ -1141,21 +1261,15 @@ void EventWorker::start()
 
             if (options.contains(QStringLiteral("element")))
             {
-                auto platform = QAEngine::instance()->getPlatform();
-                if (auto item =
-                        platform->getObject(options.value(QStringLiteral("element")).toString()))
-                {
-                    point = platform->getAbsGeometry(item).center();
-                }
+                point = elementCenter(options.value(QStringLiteral("element")).toString(), point)
+                            .toPoint();
             }
 
             const int count = options.value(QStringLiteral("count")).toInt();
-            for (int i = 0; i < count; i++)
+            for (int i = 0; i < count && !m_stopped; i++)
             {
                 sendPress(point);
-                QEventLoop loop;
-                QTimer::singleShot(200, &loop, &QEventLoop::quit);
-                loop.exec();
+                wait(200);
                 sendRelease(point);
             }
             previousPoint = point;
@@ -1166,6 +1280,12 @@ void EventWorker::start()
         }
     }
 
+    if (pointerDown && m_stopped)
+    {
+        // do not leave the touch point pressed after cancellation
+        sendRelease(previousPoint);
+    }
+
     emit finished();
 }
 
@@ -1231,7 +1351,8 @@ void EventWorker::startChain()
     int count = qMax(keyActions.size(), qMax(mouseActions.size(), wheelActions.size()));
     qDebug() << Q_FUNC_INFO << count;
 
-    for (int i = 0; i < count; i++)
+    int pressedButton = -1;
+    for (int i = 0; i < count && !m_stopped; i++)
     {
         // key action
         if (keyActions.size() > i) {
@@ -1243,9 +1364,7 @@ void EventWorker::startChain()
                 const int duration = action.value(QStringLiteral("duration"), "0").toInt();
                 if (duration > 0)
                 {
-                    QEventLoop loop;
-                    QTimer::singleShot(duration, &loop, &QEventLoop::quit);
-                    loop.exec();
+                    wait(duration);
                 }
             }
             else
@@ -1273,9 +1392,7 @@ void EventWorker::startChain()
                 const int duration = action.value(QStringLiteral("duration"), "0").toInt();
                 if (duration > 0)
                 {
-                    QEventLoop loop;
-                    QTimer::singleShot(duration, &loop, &QEventLoop::quit);
-                    loop.exec();
+                    wait(duration);
                 }
             }
             else if (type == QLatin1String("pointerMove"))
@@ -1285,7 +1402,6 @@ void EventWorker::startChain()
 
                 if (action.contains(QStringLiteral("origin")))
                 {
-                    auto platform = QAEngine::instance()->getPlatform();
                     const auto& origin = action.value(QStringLiteral("origin"));
                     QString itemId;
                     QVariantMap originMap = origin.toMap();
@@ -1298,13 +1414,10 @@ void EventWorker::startChain()
                         itemId = originMap.value(originMap.firstKey()).toString();
                     }
 
-                    if (auto item = platform->getObject(itemId))
-                    {
-                        const auto point = platform->getAbsGeometry(item).center();
-                        qDebug() << Q_FUNC_INFO << item << point;
-                        posX = point.x();
-                        posY = point.y();
-                    }
+                    const QPointF point = elementCenter(itemId, QPointF(posX, posY));
+                    qDebug() << Q_FUNC_INFO << itemId << point;
+                    posX = point.x();
+                    posY = point.y();
                 }
 
                 QList<QPointF> movePoints;
@@ -1331,9 +1444,7 @@ void EventWorker::startChain()
                 const int duration = action.value(QStringLiteral("duration"), "0").toInt();
                 if (duration > 0)
                 {
-                    QEventLoop loop;
-                    QTimer::singleShot(duration, &loop, &QEventLoop::quit);
-                    loop.exec();
+                    wait(duration);
                 }
             }
             else if (type == QLatin1String("pointerDown"))
@@ -1341,12 +1452,14 @@ void EventWorker::startChain()
                 int button = action.value(QStringLiteral("button"), 0).toInt();
                 qDebug() << Q_FUNC_INFO << "send mousePressed:" << previousPoint;
                 emit mousePressed(previousPoint, button);
+                pressedButton = button;
             }
             else if (type == QLatin1String("pointerUp"))
             {
                 int button = action.value(QStringLiteral("button"), 0).toInt();
                 qDebug() << Q_FUNC_INFO << "send mouseReleased:" << previousPoint;
                 emit mouseReleased(previousPoint, button);
+                pressedButton = -1;
 
                 previousPoint = QPointF();
             }
@@ -1375,6 +1488,11 @@ void EventWorker::startChain()
         }
     }
 
+    if (pressedButton >= 0 && m_stopped)
+    {
+        emit mouseReleased(previousPoint, pressedButton);
+    }
+
     emit finished();
 }
 
@@ -1422,9 +1540,10 @@ void EventWorker::sendMove(const QPointF& previousPoint,
     auto* interpolator = QVariantAnimationPrivate::getInterpolator(QMetaType::QPointF);
 
     QPointF pointA = previousPoint;
-    for (int currentMoveStep = 0; currentMoveStep < moveSteps; currentMoveStep++)
+    for (int currentMoveStep = 0; currentMoveStep < moveSteps && !m_stopped; currentMoveStep++)
     {
         QEventLoop loop;
+        m_wait = &loop;
         QTimer timer;
         timer.setSingleShot(true);
         connect(&timer,
@@ -1441,6 +1560,7 @@ void EventWorker::sendMove(const QPointF& previousPoint,
         connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
         timer.start(duration / moveSteps);
         loop.exec();
+        m_wait = nullptr;
     }
     sendMove(point);
 }
@@ -5,7 +5,50 @@ QAPendingEvent::QAPendingEvent(QObject* parent)
 {
 }
 
+bool QAPendingEvent::isCompleted() const
+{
+    return m_completed;
+}
+
+bool QAPendingEvent::isCancelled() const
+{
+    return m_cancelled;
+}
+
+QVariant QAPendingEvent::result() const
+{
+    return m_result;
+}
+
+void QAPendingEvent::setResult(const QVariant& result)
+{
+    m_result = result;
+}
+
+int QAPendingEvent::status() const
+{
+    return m_status;
+}
+
 void QAPendingEvent::setCompleted()
 {
+    if (m_completed)
+    {
+        return;
+    }
+    m_completed = true;
     emit completed(this);
 }
+
+void QAPendingEvent::cancel(const QString& reason, int status)
+{
+    if (m_completed)
+    {
+        return;
+    }
+    m_cancelled = true;
+    m_status = status;
+    m_result = reason;
+    emit cancelled(this);
+    setCompleted();
+}
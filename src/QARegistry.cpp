@@ -0,0 +1,169 @@
+#include <qt_qa_engine/QARegistry.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <signal.h>
+#endif
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryRegistry, "autoqa.qaengine.registry", QtWarningMsg)
+
+namespace
+{
+
+bool isProcessAlive(qint64 pid)
+{
+#if defined(Q_OS_UNIX)
+    return ::kill(pid_t(pid), 0) == 0 || errno == EPERM;
+#else
+    Q_UNUSED(pid)
+    return true;
+#endif
+}
+
+} // namespace
+
+QARegistry::QARegistry(const QString& directory)
+    : m_directory(directory)
+{
+    if (!QDir().mkpath(m_directory))
+    {
+        qCWarning(categoryRegistry) << Q_FUNC_INFO << "Can't create" << m_directory;
+        return;
+    }
+    m_valid = true;
+
+    removeStaleEntries();
+    // previous process with the same pid could not clean up
+    QFile::remove(filePath(QStringLiteral("ready")));
+
+    m_record.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
+    m_record.insert(QStringLiteral("processName"),
+                    QFileInfo(QCoreApplication::applicationFilePath()).baseName());
+    m_record.insert(QStringLiteral("started"), QDateTime::currentMSecsSinceEpoch());
+    m_record.insert(QStringLiteral("windows"), QVariantList());
+}
+
+QARegistry::~QARegistry()
+{
+    remove();
+}
+
+bool QARegistry::isValid() const
+{
+    return m_valid;
+}
+
+QString QARegistry::directory() const
+{
+    return m_directory;
+}
+
+void QARegistry::setAddress(const QVariantMap& address)
+{
+    for (auto it = address.constBegin(); it != address.constEnd(); ++it)
+    {
+        m_record.insert(it.key(), it.value());
+    }
+    publish();
+}
+
+void QARegistry::setWindows(const QVariantList& windows)
+{
+    m_record.insert(QStringLiteral("windows"), windows);
+    publish();
+}
+
+void QARegistry::markReady()
+{
+    if (!m_valid || m_ready)
+    {
+        return;
+    }
+
+    // record has to be complete before anyone sees the marker
+    if (!publish())
+    {
+        return;
+    }
+
+    QSaveFile marker(filePath(QStringLiteral("ready")));
+    if (!marker.open(QIODevice::WriteOnly))
+    {
+        qCWarning(categoryRegistry) << Q_FUNC_INFO << marker.errorString();
+        return;
+    }
+    marker.write(QByteArray::number(QCoreApplication::applicationPid()));
+    m_ready = marker.commit();
+    qCDebug(categoryRegistry) << Q_FUNC_INFO << marker.fileName() << m_ready;
+}
+
+void QARegistry::remove()
+{
+    if (!m_valid)
+    {
+        return;
+    }
+    // marker first, so a ready entry always has its record
+    QFile::remove(filePath(QStringLiteral("ready")));
+    QFile::remove(filePath(QStringLiteral("json")));
+    m_ready = false;
+}
+
+bool QARegistry::publish()
+{
+    if (!m_valid)
+    {
+        return false;
+    }
+
+    // written aside and renamed, readers never see partial record
+    QSaveFile file(filePath(QStringLiteral("json")));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(categoryRegistry) << Q_FUNC_INFO << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument::fromVariant(m_record).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+    {
+        qCWarning(categoryRegistry) << Q_FUNC_INFO << file.errorString();
+        return false;
+    }
+
+    qCDebug(categoryRegistry) << Q_FUNC_INFO << file.fileName() << m_record;
+    return true;
+}
+
+QString QARegistry::filePath(const QString& suffix) const
+{
+    return QDir(m_directory).filePath(
+        QStringLiteral("%1.%2").arg(QCoreApplication::applicationPid()).arg(suffix));
+}
+
+void QARegistry::removeStaleEntries()
+{
+    // entries of crashed processes would be enumerated forever otherwise
+    const QDir dir(m_directory);
+    const QStringList entries =
+        dir.entryList({QStringLiteral("*.json"), QStringLiteral("*.ready")}, QDir::Files);
+    for (const QString& entry : entries)
+    {
+        bool ok = false;
+        const qint64 pid = QFileInfo(entry).completeBaseName().toLongLong(&ok);
+        if (ok && pid != QCoreApplication::applicationPid() && !isProcessAlive(pid))
+        {
+            qCDebug(categoryRegistry) << Q_FUNC_INFO << "Removing stale" << entry;
+            QFile::remove(dir.filePath(entry));
+        }
+    }
+}
@@ -0,0 +1,235 @@
+#include <qt_qa_engine/ITransportClient.h>
+#include <qt_qa_engine/QAReplyStream.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryReplyStream, "autoqa.qaengine.transport.stream", QtWarningMsg)
+
+QAReplyStream::QAReplyStream(ITransportClient* client,
+                             const QVariant& requestId,
+                             ValueType type,
+                             QObject* parent)
+    : QIODevice(parent)
+    , m_client(client)
+    , m_requestId(requestId)
+    , m_type(type)
+{
+    m_chunk.reserve(s_chunkSize + 16);
+    m_chunk.append('{');
+    if (requestId.isValid())
+    {
+        // id of any JSON type, serialized as the only array element
+        const QByteArray id = QJsonDocument(QJsonArray{QJsonValue::fromVariant(requestId)})
+                                  .toJson(QJsonDocument::Compact);
+        m_chunk.append("\"id\":");
+        m_chunk.append(id.mid(1, id.size() - 2));
+        m_chunk.append(',');
+    }
+    m_chunk.append("\"status\":0,\"value\":");
+    if (m_type == StringValue)
+    {
+        m_chunk.append('"');
+    }
+
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setSingleShot(true);
+    m_drainTimer->setInterval(s_drainTimeout);
+    connect(m_drainTimer, &QTimer::timeout, this, &QAReplyStream::onDrainTimeout);
+
+    if (client)
+    {
+        // emitted on the client thread
+        connect(client,
+                &ITransportClient::lowWaterMarkReached,
+                this,
+                &QAReplyStream::resume,
+                Qt::QueuedConnection);
+        connect(client,
+                &ITransportClient::disconnected,
+                this,
+                &QAReplyStream::abort,
+                Qt::QueuedConnection);
+    }
+
+    open(QIODevice::WriteOnly);
+}
+
+QAReplyStream::~QAReplyStream()
+{
+    if (m_step && m_client)
+    {
+        // deleted in the middle of the value, the peer can't parse what follows
+        m_step = nullptr;
+        abort();
+        QMetaObject::invokeMethod(m_client, "close", Qt::QueuedConnection);
+    }
+    finish();
+}
+
+void QAReplyStream::finish()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    if (m_type == StringValue)
+    {
+        m_chunk.append('"');
+    }
+    m_chunk.append('}');
+    flushChunk(true);
+    close();
+
+    // truncated reply was never completed, the connection is closed instead
+    if (m_client && !m_aborted)
+    {
+        emit m_client->replySent(m_client, m_requestId);
+    }
+}
+
+void QAReplyStream::start(const std::function<bool()>& step)
+{
+    m_step = step;
+    resume();
+}
+
+void QAReplyStream::resume()
+{
+    if (!m_step || m_aborted)
+    {
+        return;
+    }
+    if (!m_client)
+    {
+        abort();
+        return;
+    }
+
+    m_paused = false;
+    m_drainTimer->stop();
+    while (!m_client->isBackpressured())
+    {
+        if (!m_step())
+        {
+            m_step = nullptr;
+            finish();
+            deleteLater();
+            return;
+        }
+    }
+
+    // lowWaterMarkReached arrives through the event loop, stale ones find it still backpressured
+    qCDebug(categoryReplyStream) << Q_FUNC_INFO << m_client << "paused:" << m_client->pendingBytes();
+    m_paused = true;
+    m_drainTimer->start();
+}
+
+void QAReplyStream::abort()
+{
+    if (m_aborted || !isOpen())
+    {
+        return;
+    }
+    qCDebug(categoryReplyStream) << Q_FUNC_INFO << m_client;
+
+    m_aborted = true;
+    m_drainTimer->stop();
+    close();
+    if (m_step)
+    {
+        m_step = nullptr;
+        deleteLater();
+    }
+}
+
+void QAReplyStream::onDrainTimeout()
+{
+    if (!m_paused || !m_client)
+    {
+        return;
+    }
+    qCWarning(categoryReplyStream)
+        << Q_FUNC_INFO << m_client << "peer does not read, closing connection";
+    QMetaObject::invokeMethod(m_client, "close", Qt::QueuedConnection);
+    abort();
+}
+
+qint64 QAReplyStream::readData(char*, qint64)
+{
+    return -1;
+}
+
+qint64 QAReplyStream::writeData(const char* data, qint64 size)
+{
+    if (m_type == JsonValue)
+    {
+        m_chunk.append(data, int(size));
+    }
+    else
+    {
+        static const char hex[] = "0123456789abcdef";
+        for (qint64 i = 0; i < size; i++)
+        {
+            const uchar c = uchar(data[i]);
+            switch (c)
+            {
+                case '"':
+                    m_chunk.append("\\\"");
+                    break;
+                case '\\':
+                    m_chunk.append("\\\\");
+                    break;
+                case '\n':
+                    m_chunk.append("\\n");
+                    break;
+                case '\r':
+                    m_chunk.append("\\r");
+                    break;
+                case '\t':
+                    m_chunk.append("\\t");
+                    break;
+                default:
+                    if (c < 0x20)
+                    {
+                        m_chunk.append("\\u00");
+                        m_chunk.append(hex[c >> 4]);
+                        m_chunk.append(hex[c & 0xf]);
+                    }
+                    else
+                    {
+                        // UTF-8 multibyte sequences pass through untouched
+                        m_chunk.append(char(c));
+                    }
+                    break;
+            }
+        }
+    }
+
+    if (m_chunk.size() >= s_chunkSize)
+    {
+        flushChunk();
+    }
+    return size;
+}
+
+void QAReplyStream::flushChunk(bool last)
+{
+    if (m_chunk.isEmpty())
+    {
+        return;
+    }
+
+    if (m_client && !m_aborted)
+    {
+        qCDebug(categoryReplyStream) << Q_FUNC_INFO << m_client << m_chunk.size() << last;
+        m_client->postStreamChunk(m_chunk, last);
+    }
+    // posted chunk is shared with the queue, start a fresh one instead of detaching
+    m_chunk = QByteArray();
+    m_chunk.reserve(s_chunkSize + 16);
+}
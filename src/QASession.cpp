@@ -0,0 +1,387 @@
+#include <qt_qa_engine/ITransportClient.h>
+#include <qt_qa_engine/QAPendingEvent.h>
+#include <qt_qa_engine/QASession.h>
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categorySession, "autoqa.qaengine.session", QtWarningMsg)
+
+namespace
+{
+
+QHash<ITransportClient*, QASession*> s_sessions;
+QASession* s_current = nullptr;
+
+// objects in reverse indexes of all sessions, read by object hooks on any thread
+QAtomicInt s_trackedItems;
+
+} // namespace
+
+QASession* QASession::forClient(ITransportClient* client)
+{
+    if (!client)
+    {
+        return nullptr;
+    }
+    client = client->sessionClient();
+
+    QASession* session = s_sessions.value(client);
+    if (!session)
+    {
+        session = new QASession(client);
+        s_sessions.insert(client, session);
+        qCDebug(categorySession) << Q_FUNC_INFO << "New session:" << session << client;
+    }
+    return session;
+}
+
+QASession* QASession::find(ITransportClient* client)
+{
+    return client ? s_sessions.value(client->sessionClient()) : nullptr;
+}
+
+void QASession::close(ITransportClient* client)
+{
+    QASession* session = s_sessions.take(client);
+    qCDebug(categorySession) << Q_FUNC_INFO << session << client;
+
+    if (s_current == session)
+    {
+        s_current = nullptr;
+    }
+    delete session;
+}
+
+QList<QASession*> QASession::sessions()
+{
+    return s_sessions.values();
+}
+
+void QASession::removeItemFromSessions(QObject* platform, QObject* item)
+{
+    for (auto it = s_sessions.constBegin(); it != s_sessions.constEnd(); ++it)
+    {
+        it.value()->removeItem(platform, item);
+    }
+}
+
+QASession* QASession::current()
+{
+    if (QThread::currentThread() != QCoreApplication::instance()->thread())
+    {
+        return nullptr;
+    }
+    return s_current;
+}
+
+QASession::Scope::Scope(QASession* session)
+    : m_previous(s_current)
+{
+    s_current = session;
+}
+
+QASession::Scope::~Scope()
+{
+    s_current = m_previous;
+}
+
+QASession::QASession(ITransportClient* client, QObject* parent)
+    : QObject(parent)
+    , m_client(client)
+{
+    connect(client, &ITransportClient::replySent, this, &QASession::onReplySent);
+}
+
+QASession::~QASession()
+{
+    s_trackedItems.fetchAndAddOrdered(-m_itemIds.size());
+
+    // stops waits and input sequences the client started, replies are dropped
+    cancel(QVariant(), QStringLiteral("disconnected"));
+}
+
+ITransportClient* QASession::client() const
+{
+    return m_client;
+}
+
+bool QASession::admitCommand(const QACommand& command)
+{
+    if (command.id.isValid() || command.admitted)
+    {
+        return true;
+    }
+
+    if (m_anonymousInFlight)
+    {
+        qCDebug(categorySession) << Q_FUNC_INFO << "Queued:" << command.action
+                                 << "backlog:" << m_anonymousBacklog.size();
+        m_anonymousBacklog.enqueue(command);
+        return false;
+    }
+
+    m_anonymousInFlight = true;
+    return true;
+}
+
+void QASession::beginDispatch(const QACommand& command)
+{
+    m_dispatchingAnonymous = !command.id.isValid();
+    m_anonymousReplied = false;
+    m_replyDeferred = false;
+}
+
+void QASession::deferReply()
+{
+    m_replyDeferred = true;
+}
+
+void QASession::endDispatch()
+{
+    if (m_dispatchingAnonymous && !m_anonymousReplied && !m_replyDeferred)
+    {
+        // initialize, startAnalyze, stopAnalyze and alike never replied, keep it that way
+        qCDebug(categorySession) << Q_FUNC_INFO << "Command without id did not reply";
+        releaseAnonymous();
+    }
+    m_dispatchingAnonymous = false;
+    m_anonymousReplied = false;
+    m_replyDeferred = false;
+}
+
+void QASession::setCommandDeadline(qint64 remainingMsecs)
+{
+    m_commandDeadline = remainingMsecs;
+}
+
+void QASession::trackPending(const QVariant& requestId, QAPendingEvent* pending)
+{
+    if (!pending || pending->isCompleted())
+    {
+        return;
+    }
+    // the command replies once the event completes
+    deferReply();
+
+    m_pending.append({requestId, pending});
+    connect(pending,
+            &QAPendingEvent::completed,
+            this,
+            [this](QAPendingEvent* event)
+            {
+                for (int i = m_pending.size() - 1; i >= 0; i--)
+                {
+                    if (!m_pending.at(i).event || m_pending.at(i).event == event)
+                    {
+                        m_pending.removeAt(i);
+                    }
+                }
+            });
+
+    if (m_commandDeadline >= 0)
+    {
+        QTimer::singleShot(m_commandDeadline,
+                           pending,
+                           [pending]()
+                           { pending->cancel(QStringLiteral("timeout"), s_timeoutStatus); });
+    }
+}
+
+int QASession::cancel(const QVariant& requestId, const QString& reason, int status)
+{
+    qCDebug(categorySession) << Q_FUNC_INFO << requestId << reason;
+
+    QList<QPointer<QAPendingEvent>> events;
+    for (const PendingRequest& request : m_pending)
+    {
+        if (!requestId.isValid() || request.requestId == requestId)
+        {
+            events.append(request.event);
+        }
+    }
+
+    int cancelled = 0;
+    for (const QPointer<QAPendingEvent>& event : events)
+    {
+        if (event && !event->isCompleted())
+        {
+            event->cancel(reason, status);
+            cancelled++;
+        }
+    }
+    return cancelled;
+}
+
+void QASession::onReplySent(ITransportClient* client, const QVariant& requestId)
+{
+    if (client != m_client || requestId.isValid())
+    {
+        return;
+    }
+    if (m_dispatchingAnonymous)
+    {
+        m_anonymousReplied = true;
+    }
+    releaseAnonymous();
+}
+
+void QASession::releaseAnonymous()
+{
+    if (!m_anonymousInFlight)
+    {
+        return;
+    }
+
+    if (m_anonymousBacklog.isEmpty())
+    {
+        m_anonymousInFlight = false;
+        return;
+    }
+
+    // stays in flight on behalf of the next command
+    QACommand command = m_anonymousBacklog.dequeue();
+    command.admitted = true;
+    emit commandReady(m_client, command);
+}
+
+void QASession::insertItem(QObject* platform, const QString& elementId, QObject* item)
+{
+    QHash<QString, QObject*>& items = m_items[platform];
+    auto previous = items.find(elementId);
+    if (previous != items.end() && previous.value() != item)
+    {
+        // id of an object that was destroyed without the remove hook
+        auto ids = m_itemIds.find(previous.value());
+        if (ids != m_itemIds.end())
+        {
+            ids->remove(platform);
+            if (ids->isEmpty())
+            {
+                m_itemIds.erase(ids);
+                s_trackedItems.deref();
+            }
+        }
+    }
+
+    items.insert(elementId, item);
+    auto ids = m_itemIds.find(item);
+    if (ids == m_itemIds.end())
+    {
+        ids = m_itemIds.insert(item, QHash<QObject*, QString>());
+        s_trackedItems.ref();
+    }
+    ids->insert(platform, elementId);
+}
+
+QObject* QASession::item(QObject* platform, const QString& elementId) const
+{
+    auto items = m_items.constFind(platform);
+    return items == m_items.constEnd() ? nullptr : items->value(elementId);
+}
+
+bool QASession::containsItem(QObject* platform, const QString& elementId) const
+{
+    auto items = m_items.constFind(platform);
+    return items != m_items.constEnd() && items->contains(elementId);
+}
+
+void QASession::removeItem(QObject* platform, QObject* item)
+{
+    auto ids = m_itemIds.find(item);
+    if (ids == m_itemIds.end())
+    {
+        return;
+    }
+
+    auto id = ids->find(platform);
+    if (id == ids->end())
+    {
+        return;
+    }
+
+    auto items = m_items.find(platform);
+    if (items != m_items.end())
+    {
+        auto i = items->find(id.value());
+        if (i != items->end() && i.value() == item)
+        {
+            items->erase(i);
+        }
+    }
+
+    ids->erase(id);
+    if (ids->isEmpty())
+    {
+        m_itemIds.erase(ids);
+        s_trackedItems.deref();
+    }
+}
+
+bool QASession::hasTrackedItems()
+{
+    return s_trackedItems.loadAcquire() > 0;
+}
+
+QVariantList QASession::lastFilters() const
+{
+    return m_lastFilters;
+}
+
+void QASession::setLastFilters(const QVariantList& filters)
+{
+    m_lastFilters = filters;
+}
+
+void QASession::registerSignal(const QString& key, QObject* item, const QString& signalName)
+{
+    SignalRegistration registration;
+    registration.item = item;
+    registration.signalName = signalName;
+    m_signals.insert(key, registration);
+}
+
+void QASession::unregisterSignal(const QString& key)
+{
+    m_signals.remove(key);
+}
+
+bool QASession::hasSignal(const QString& key) const
+{
+    return m_signals.contains(key);
+}
+
+void QASession::countSignal(const QString& key)
+{
+    auto registration = m_signals.find(key);
+    if (registration != m_signals.end())
+    {
+        registration->count += 1;
+        qCDebug(categorySession) << Q_FUNC_INFO << this << key << registration->count;
+    }
+}
+
+int QASession::signalCount(const QString& key) const
+{
+    auto registration = m_signals.constFind(key);
+    return registration == m_signals.constEnd() ? -1 : registration->count;
+}
+
+QHash<QString, QASession::SignalRegistration> QASession::signalRegistrations() const
+{
+    return m_signals;
+}
+
+bool QASession::isAnalyzeActive() const
+{
+    return m_analyzeActive;
+}
+
+void QASession::setAnalyzeActive(bool active)
+{
+    m_analyzeActive = active;
+}
@@ -0,0 +1,119 @@
+#include <qt_qa_engine/QASharedMemoryChannel.h>
+
+#include <QCoreApplication>
+#include <QUuid>
+
+#include <cstring>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categorySharedMemoryChannel, "autoqa.qaengine.transport.shm", QtWarningMsg)
+
+QASharedMemoryChannel::QASharedMemoryChannel(int size)
+{
+    const QString key = QStringLiteral("qaengine-%1-%2")
+                            .arg(QCoreApplication::applicationPid())
+                            .arg(QUuid::createUuid().toString().mid(1, 8));
+    m_memory.setKey(key);
+
+    if (!m_memory.create(qMax(size, s_headerSize + 1)))
+    {
+        qCWarning(categorySharedMemoryChannel) << Q_FUNC_INFO << key << m_memory.errorString();
+        return;
+    }
+
+    m_memory.lock();
+    memset(m_memory.data(), 0, s_headerSize);
+    m_memory.unlock();
+
+    qCDebug(categorySharedMemoryChannel)
+        << Q_FUNC_INFO << m_memory.key() << m_memory.nativeKey() << m_memory.size();
+}
+
+bool QASharedMemoryChannel::isValid() const
+{
+    return m_memory.isAttached();
+}
+
+int QASharedMemoryChannel::size() const
+{
+    return m_memory.size();
+}
+
+QVariantMap QASharedMemoryChannel::description() const
+{
+    QVariantMap desc;
+    desc.insert(QStringLiteral("key"), m_memory.key());
+    desc.insert(QStringLiteral("nativeKey"), m_memory.nativeKey());
+    desc.insert(QStringLiteral("size"), m_memory.size());
+    desc.insert(QStringLiteral("headerSize"), s_headerSize);
+    return desc;
+}
+
+QVariant QASharedMemoryChannel::write(const QByteArray& payload)
+{
+    if (!isValid() || payload.size() > m_memory.size() - s_headerSize)
+    {
+        return QVariant();
+    }
+
+    if (!m_memory.lock())
+    {
+        qCWarning(categorySharedMemoryChannel) << Q_FUNC_INFO << m_memory.errorString();
+        return QVariant();
+    }
+
+    releaseRegions();
+    const int offset = allocate(payload.size());
+    if (offset < 0)
+    {
+        m_memory.unlock();
+        qCDebug(categorySharedMemoryChannel)
+            << Q_FUNC_INFO << "ring is full," << m_regions.size() << "payloads not released";
+        return QVariant();
+    }
+    memcpy(static_cast<char*>(m_memory.data()) + offset, payload.constData(), payload.size());
+    m_memory.unlock();
+
+    m_regions.enqueue({offset, payload.size(), ++m_sequence});
+
+    QVariantMap handle;
+    handle.insert(QStringLiteral("shm"), m_memory.key());
+    handle.insert(QStringLiteral("offset"), offset);
+    handle.insert(QStringLiteral("length"), payload.size());
+    handle.insert(QStringLiteral("sequence"), m_sequence);
+    return handle;
+}
+
+void QASharedMemoryChannel::releaseRegions()
+{
+    quint64 released = 0;
+    memcpy(&released, m_memory.constData(), sizeof(released));
+
+    while (!m_regions.isEmpty() && m_regions.head().sequence <= released)
+    {
+        m_regions.dequeue();
+    }
+}
+
+int QASharedMemoryChannel::allocate(int length) const
+{
+    if (m_regions.isEmpty())
+    {
+        return s_headerSize;
+    }
+
+    // payloads are never split, free space is after the newest region and before the oldest one
+    const Region& oldest = m_regions.head();
+    const Region& newest = m_regions.last();
+    const int head = newest.offset + newest.length;
+    if (newest.offset >= oldest.offset)
+    {
+        if (m_memory.size() - head >= length)
+        {
+            return head;
+        }
+        return oldest.offset - s_headerSize >= length ? int(s_headerSize) : -1;
+    }
+    return oldest.offset - head >= length ? head : -1;
+}
@@ -0,0 +1,205 @@
+#include <qt_qa_engine/QAStats.h>
+#include <qt_qa_engine/QATrace.h>
+
+#include <QMutexLocker>
+
+namespace
+{
+
+// histograms are never removed, so returned pointers stay valid without holding the lock
+QMutex s_statsMutex;
+QHash<QString, QAHistogram*> s_histograms;
+
+// resolved keys of this thread, recording does not touch the shared registry
+thread_local QHash<QString, QAStats::Key> t_keys;
+
+} // namespace
+
+QAHistogram::QAHistogram()
+    : m_count(0)
+    , m_sum(0)
+    , m_max(0)
+{
+    reset();
+}
+
+void QAHistogram::record(qint64 usecs)
+{
+    usecs = qMax<qint64>(usecs, 0);
+    m_buckets[bucketIndex(usecs)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(usecs);
+
+    qint64 max = m_max.loadAcquire();
+    while (usecs > max && !m_max.testAndSetOrdered(max, usecs))
+    {
+        max = m_max.loadAcquire();
+    }
+}
+
+void QAHistogram::reset()
+{
+    for (int i = 0; i < s_bucketCount; i++)
+    {
+        m_buckets[i].storeRelease(0);
+    }
+    m_count.storeRelease(0);
+    m_sum.storeRelease(0);
+    m_max.storeRelease(0);
+}
+
+qint64 QAHistogram::count() const
+{
+    return m_count.loadAcquire();
+}
+
+qint64 QAHistogram::percentile(double percent) const
+{
+    const qint64 total = count();
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    const qint64 rank = qMax<qint64>(1, qint64(total * percent / 100.0 + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < s_bucketCount; i++)
+    {
+        seen += m_buckets[i].loadAcquire();
+        if (seen >= rank)
+        {
+            return qMin(bucketValue(i), m_max.loadAcquire());
+        }
+    }
+    return m_max.loadAcquire();
+}
+
+QVariantMap QAHistogram::summary() const
+{
+    const qint64 total = count();
+
+    QVariantMap result;
+    result.insert(QStringLiteral("count"), total);
+    result.insert(QStringLiteral("mean"), total ? m_sum.loadAcquire() / total : 0);
+    result.insert(QStringLiteral("p50"), percentile(50));
+    result.insert(QStringLiteral("p90"), percentile(90));
+    result.insert(QStringLiteral("p99"), percentile(99));
+    result.insert(QStringLiteral("max"), m_max.loadAcquire());
+    return result;
+}
+
+int QAHistogram::bucketIndex(qint64 usecs)
+{
+    if (usecs < s_subBuckets)
+    {
+        return int(usecs);
+    }
+
+    int exponent = 63 - qCountLeadingZeroBits(quint64(usecs));
+    if (exponent > s_maxExponent)
+    {
+        return s_bucketCount - 1;
+    }
+    const int subBucket = int(usecs >> (exponent - s_subBucketBits)) & (s_subBuckets - 1);
+    return (exponent - s_subBucketBits + 1) * s_subBuckets + subBucket;
+}
+
+qint64 QAHistogram::bucketValue(int index)
+{
+    if (index < s_subBuckets)
+    {
+        return index;
+    }
+
+    // upper bound of the bucket, percentiles never under-report
+    const int exponent = index / s_subBuckets + s_subBucketBits - 1;
+    const qint64 subBucket = index % s_subBuckets;
+    const qint64 lower = (qint64(s_subBuckets) + subBucket) << (exponent - s_subBucketBits);
+    return lower + (qint64(1) << (exponent - s_subBucketBits)) - 1;
+}
+
+QAStats::Key QAStats::key(const QString& name)
+{
+    Key key = t_keys.value(name);
+    if (key.histogram)
+    {
+        return key;
+    }
+
+    {
+        QMutexLocker lock(&s_statsMutex);
+
+        QAHistogram*& histogram = s_histograms[name];
+        if (!histogram)
+        {
+            histogram = new QAHistogram;
+        }
+        key.histogram = histogram;
+    }
+    key.traceName = QATrace::intern(name);
+    t_keys.insert(name, key);
+    return key;
+}
+
+void QAStats::record(const Key& key, qint64 nsecs)
+{
+    key.histogram->record(nsecs / 1000);
+
+    if (QATrace::isEnabled())
+    {
+        // span ends now, recorded on the thread that measured it
+        QATrace::record(key.traceName, QATrace::now() - nsecs, nsecs);
+    }
+}
+
+void QAStats::record(const QString& key, qint64 nsecs)
+{
+    record(QAStats::key(key), nsecs);
+}
+
+QVariantMap QAStats::summary()
+{
+    QMutexLocker lock(&s_statsMutex);
+
+    QVariantMap result;
+    for (auto it = s_histograms.constBegin(); it != s_histograms.constEnd(); ++it)
+    {
+        if (it.value()->count() > 0)
+        {
+            result.insert(it.key(), it.value()->summary());
+        }
+    }
+    return result;
+}
+
+void QAStats::reset()
+{
+    QMutexLocker lock(&s_statsMutex);
+
+    for (QAHistogram* histogram : s_histograms)
+    {
+        histogram->reset();
+    }
+}
+
+QAStats::Timer::Timer(const Key& key)
+    : m_key(key)
+{
+    m_timer.start();
+}
+
+QAStats::Timer::Timer(const QString& key)
+    : m_key(QAStats::key(key))
+{
+    m_timer.start();
+}
+
+QAStats::Timer::~Timer()
+{
+    QAStats::record(m_key, m_timer.nsecsElapsed());
+}
+
+void QAStats::Timer::setKey(const QString& key)
+{
+    m_key = QAStats::key(key);
+}
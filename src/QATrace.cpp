@@ -0,0 +1,422 @@
+#include <qt_qa_engine/QATrace.h>
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+#include <QLoggingCategory>
+
+#include <functional>
+
+Q_LOGGING_CATEGORY(categoryTrace, "autoqa.qaengine.trace", QtWarningMsg)
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char* name;
+    qint64 start;
+    qint64 duration;
+};
+
+// written only by the owning thread, events below count are complete and never change
+// until the owner sees a new generation or another thread adopts the retired buffer,
+// so readers holding s_buffersMutex need no other lock
+struct ThreadBuffer
+{
+    QAtomicPointer<TraceEvent> chunks[QATrace::s_maxChunks];
+    QAtomicInt count;
+    QAtomicInt dropped;
+    QAtomicInt generation;
+
+    // guarded by s_buffersMutex
+    int threadId = 0;
+    QString threadName;
+    bool retired = false;
+};
+
+// events of a finished thread copied out of its buffer when another thread adopts it
+struct FinishedThread
+{
+    int threadId = 0;
+    QString threadName;
+    QVector<TraceEvent> events;
+};
+
+QAtomicInt s_enabled;
+QAtomicInt s_generation;
+// events of threads that found no free buffer
+QAtomicInt s_dropped;
+QAtomicInt s_retiredBuffers;
+
+// buffers of finished threads are retired and adopted by new threads, never freed,
+// at most QATrace::s_maxBuffers exist
+QMutex s_buffersMutex;
+QList<ThreadBuffer*> s_buffers;
+int s_nextThreadId = 1;
+// guarded by s_buffersMutex, events of the current trace only
+QList<FinishedThread> s_finished;
+int s_finishedEvents = 0;
+int s_finishedDropped = 0;
+int s_finishedGeneration = 0;
+
+// interned names are never freed, so events may keep plain pointers
+QMutex s_namesMutex;
+QHash<QString, QByteArray*> s_names;
+
+struct ThreadSlot
+{
+    ThreadBuffer* buffer = nullptr;
+    // all buffers were taken, retried only once one is retired
+    bool starved = false;
+    QHash<QString, const char*> names;
+
+    ~ThreadSlot()
+    {
+        if (buffer)
+        {
+            QMutexLocker locker(&s_buffersMutex);
+            buffer->retired = true;
+            s_retiredBuffers.ref();
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+const QElapsedTimer& clock()
+{
+    static const QElapsedTimer timer = []()
+    {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+
+// called with s_buffersMutex locked, the owner of a retired buffer is gone
+void keepFinishedEvents(ThreadBuffer* buffer, int generation)
+{
+    if (s_finishedGeneration != generation)
+    {
+        s_finished.clear();
+        s_finishedEvents = 0;
+        s_finishedDropped = 0;
+        s_finishedGeneration = generation;
+    }
+    if (buffer->generation.loadAcquire() != generation)
+    {
+        return;
+    }
+
+    const int count = buffer->count.loadAcquire();
+    const int kept = qMin(count, QATrace::s_chunkSize * QATrace::s_maxChunks - s_finishedEvents);
+    s_finishedDropped += buffer->dropped.loadAcquire() + count - kept;
+    if (kept <= 0)
+    {
+        return;
+    }
+
+    FinishedThread finished;
+    finished.threadId = buffer->threadId;
+    finished.threadName = buffer->threadName;
+    finished.events.reserve(kept);
+    for (int i = 0; i < kept; i++)
+    {
+        const TraceEvent* events = buffer->chunks[i / QATrace::s_chunkSize].loadAcquire();
+        finished.events.append(events[i % QATrace::s_chunkSize]);
+    }
+    s_finished.append(finished);
+    s_finishedEvents += kept;
+}
+
+void resetBuffer(ThreadBuffer* buffer, int generation)
+{
+    buffer->count.storeRelease(0);
+    buffer->dropped.storeRelease(0);
+    buffer->generation.storeRelease(generation);
+}
+
+ThreadBuffer* threadBuffer()
+{
+    const int generation = s_generation.loadAcquire();
+    ThreadBuffer* buffer = t_slot.buffer;
+    if (buffer)
+    {
+        if (buffer->generation.loadAcquire() != generation)
+        {
+            resetBuffer(buffer, generation);
+        }
+        return buffer;
+    }
+    if (t_slot.starved && s_retiredBuffers.loadAcquire() == 0)
+    {
+        return nullptr;
+    }
+
+    QThread* thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (threadName.isEmpty())
+    {
+        threadName = thread == QCoreApplication::instance()->thread()
+                         ? QStringLiteral("GUI")
+                         : QStringLiteral("Thread");
+    }
+
+    QMutexLocker locker(&s_buffersMutex);
+    for (ThreadBuffer* retired : s_buffers)
+    {
+        if (retired->retired)
+        {
+            buffer = retired;
+            break;
+        }
+    }
+    if (buffer)
+    {
+        // short-lived threads, e.g. one EventWorker per gesture, recycle the same buffers
+        keepFinishedEvents(buffer, generation);
+        s_retiredBuffers.deref();
+    }
+    else if (s_buffers.size() < QATrace::s_maxBuffers)
+    {
+        buffer = new ThreadBuffer;
+        s_buffers.append(buffer);
+    }
+    else
+    {
+        t_slot.starved = true;
+        return nullptr;
+    }
+    t_slot.starved = false;
+    buffer->retired = false;
+    buffer->threadId = s_nextThreadId++;
+    buffer->threadName = threadName;
+    resetBuffer(buffer, generation);
+
+    t_slot.buffer = buffer;
+    return buffer;
+}
+
+void appendJsonString(QByteArray* json, const char* text)
+{
+    json->append('"');
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            json->append('\\');
+            json->append(*c);
+        }
+        else if (uchar(*c) < 0x20)
+        {
+            json->append("\\u00");
+            json->append("0123456789abcdef"[uchar(*c) >> 4]);
+            json->append("0123456789abcdef"[uchar(*c) & 0xf]);
+        }
+        else
+        {
+            json->append(*c);
+        }
+    }
+    json->append('"');
+}
+
+void appendMicroseconds(QByteArray* json, qint64 nsecs)
+{
+    json->append(QByteArray::number(double(nsecs) / 1000.0, 'f', 3));
+}
+
+} // namespace
+
+bool QATrace::isEnabled()
+{
+    return s_enabled.loadAcquire();
+}
+
+void QATrace::start()
+{
+    qCDebug(categoryTrace) << Q_FUNC_INFO;
+
+    clock();
+    s_dropped.storeRelease(0);
+    s_generation.fetchAndAddOrdered(1);
+    s_enabled.storeRelease(1);
+}
+
+void QATrace::stop()
+{
+    qCDebug(categoryTrace) << Q_FUNC_INFO;
+
+    s_enabled.storeRelease(0);
+}
+
+void QATrace::record(const char* name, qint64 startNsecs, qint64 durationNsecs)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    ThreadBuffer* buffer = threadBuffer();
+    if (!buffer)
+    {
+        s_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+    const int index = buffer->count.loadAcquire();
+    const int chunk = index / s_chunkSize;
+    if (chunk >= s_maxChunks)
+    {
+        buffer->dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    TraceEvent* events = buffer->chunks[chunk].loadAcquire();
+    if (!events)
+    {
+        events = new TraceEvent[s_chunkSize];
+        buffer->chunks[chunk].storeRelease(events);
+    }
+    events[index % s_chunkSize] = {name, startNsecs, durationNsecs};
+    buffer->count.storeRelease(index + 1);
+}
+
+const char* QATrace::intern(const QString& name)
+{
+    const char* interned = t_slot.names.value(name);
+    if (interned)
+    {
+        return interned;
+    }
+
+    QMutexLocker locker(&s_namesMutex);
+    QByteArray* utf8 = s_names.value(name);
+    if (!utf8)
+    {
+        utf8 = new QByteArray(name.toUtf8());
+        s_names.insert(name, utf8);
+    }
+    interned = utf8->constData();
+    t_slot.names.insert(name, interned);
+    return interned;
+}
+
+qint64 QATrace::now()
+{
+    return clock().nsecsElapsed();
+}
+
+QByteArray QATrace::toJson()
+{
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    const int generation = s_generation.loadAcquire();
+
+    QByteArray json;
+    json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    int dropped = s_dropped.loadAcquire();
+
+    auto appendThread = [&](int threadId, const QString& threadName, int count,
+                            const std::function<const TraceEvent&(int)>& eventAt)
+    {
+        const QByteArray tid = QByteArray::number(threadId);
+        if (!first)
+        {
+            json.append(',');
+        }
+        first = false;
+        json.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                    + ",\"args\":{\"name\":");
+        appendJsonString(&json, threadName.toUtf8().constData());
+        json.append("}}");
+
+        for (int i = 0; i < count; i++)
+        {
+            const TraceEvent& event = eventAt(i);
+            json.append(",{\"name\":");
+            appendJsonString(&json, event.name);
+            json.append(",\"cat\":\"qaengine\",\"ph\":\"X\",\"ts\":");
+            appendMicroseconds(&json, event.start);
+            json.append(",\"dur\":");
+            appendMicroseconds(&json, event.duration);
+            json.append(",\"pid\":" + pid + ",\"tid\":" + tid + "}");
+        }
+    };
+
+    QMutexLocker locker(&s_buffersMutex);
+    if (s_finishedGeneration == generation)
+    {
+        dropped += s_finishedDropped;
+        for (const FinishedThread& finished : s_finished)
+        {
+            appendThread(finished.threadId,
+                         finished.threadName,
+                         finished.events.size(),
+                         [&finished](int i) -> const TraceEvent& { return finished.events.at(i); });
+        }
+    }
+    for (ThreadBuffer* buffer : s_buffers)
+    {
+        if (buffer->generation.loadAcquire() != generation)
+        {
+            continue;
+        }
+        const int count = buffer->count.loadAcquire();
+        dropped += buffer->dropped.loadAcquire();
+        if (count == 0)
+        {
+            continue;
+        }
+        appendThread(buffer->threadId,
+                     buffer->threadName,
+                     count,
+                     [buffer](int i) -> const TraceEvent&
+                     { return buffer->chunks[i / s_chunkSize].loadAcquire()[i % s_chunkSize]; });
+    }
+    locker.unlock();
+
+    json.append("],\"otherData\":{\"dropped\":" + QByteArray::number(dropped) + "}}");
+    return json;
+}
+
+bool QATrace::save(const QString& filePath)
+{
+    qCDebug(categoryTrace) << Q_FUNC_INFO << filePath;
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(categoryTrace) << Q_FUNC_INFO << "Can't open" << filePath << file.errorString();
+        return false;
+    }
+    file.write(toJson());
+    return file.commit();
+}
+
+QATrace::Span::Span(const char* name)
+{
+    if (isEnabled())
+    {
+        m_name = name;
+        m_start = now();
+    }
+}
+
+QATrace::Span::~Span()
+{
+    if (m_name)
+    {
+        record(m_name, m_start, now() - m_start);
+    }
+}
@@ -1,6 +1,7 @@
 #include <qt_qa_engine/ITransportClient.h>
 #include <qt_qa_engine/QAEngine.h>
 #include <qt_qa_engine/QAKeyMouseEngine.h>
+#include <qt_qa_engine/QASession.h>
 #include <qt_qa_engine/QuickEnginePlatform.h>
 
 #include <QBuffer>
@@ -433,15 +434,17 @@ void QuickEnginePlatform::grabScreenshot(ITransportClient* socket,
             pix.save(&buffer, "PNG");
         }
 
-        socketReply(socket, arr.toBase64());
+        socketReply(socket, socket->payloadValue(arr));
     }
     else
     {
         QSharedPointer<QQuickItemGrabResult> grabber = q->grabToImage();
+        const QVariant requestId = socket->requestId();
+        QASession::forClient(socket)->deferReply();
 
         connect(grabber.data(),
                 &QQuickItemGrabResult::ready,
-                [this, grabber, socket, fillBackground]()
+                [this, grabber, socket, requestId, fillBackground]()
                 {
                     QByteArray arr;
                     QBuffer buffer(&arr);
@@ -458,28 +461,23 @@ void QuickEnginePlatform::grabScreenshot(ITransportClient* socket,
                     {
                         grabber->image().save(&buffer, "PNG");
                     }
-                    socketReply(socket, arr.toBase64());
+                    deferredReply(socket, requestId, socket->payloadValue(arr));
                 });
     }
 }
 
-void QuickEnginePlatform::pressAndHoldItem(QObject* qitem, int delay)
+QAPendingEvent* QuickEnginePlatform::pressAndHoldItem(QObject* qitem, int delay)
 {
     qCDebug(categoryQuickEnginePlatform) << Q_FUNC_INFO << qitem << delay;
 
-    if (!qitem)
-    {
-        return;
-    }
-
     QQuickItem* item = qobject_cast<QQuickItem*>(qitem);
     if (!item)
     {
-        return;
+        return completedEvent(QVariant());
     }
 
     const QPointF itemAbs = getAbsPosition(item);
-    pressAndHold(itemAbs.x() + item->width() / 2, itemAbs.y() + item->height() / 2, delay);
+    return pressAndHold(itemAbs.x() + item->width() / 2, itemAbs.y() + item->height() / 2, delay);
 }
 
 void QuickEnginePlatform::clearFocus()
@@ -522,8 +520,7 @@ void QuickEnginePlatform::executeCommand_touch_pressAndHold(ITransportClient* so
 {
     qCDebug(categoryQuickEnginePlatform) << Q_FUNC_INFO << socket << posx << posy;
 
-    pressAndHold(posx, posy);
-    socketReply(socket, QString());
+    pendingReply(socket, pressAndHold(posx, posy));
 }
 
 void QuickEnginePlatform::executeCommand_touch_mouseSwipe(
@@ -531,8 +528,7 @@ void QuickEnginePlatform::executeCommand_touch_mouseSwipe(
 {
     qCDebug(categoryQuickEnginePlatform) << Q_FUNC_INFO << socket << posx << posy << stopx << stopy;
 
-    mouseMove(posx, posy, stopx, stopy);
-    socketReply(socket, QString());
+    pendingReply(socket, mouseMove(posx, posy, stopx, stopy));
 }
 
 void QuickEnginePlatform::executeCommand_touch_mouseDrag(
@@ -540,8 +536,7 @@ void QuickEnginePlatform::executeCommand_touch_mouseDrag(
 {
     qCDebug(categoryQuickEnginePlatform) << Q_FUNC_INFO << socket << posx << posy << stopx << stopy;
 
-    mouseDrag(posx, posy, stopx, stopy);
-    socketReply(socket, QString());
+    pendingReply(socket, mouseDrag(posx, posy, stopx, stopy));
 }
 
 void QuickEnginePlatform::executeCommand_app_js(ITransportClient* socket,
@@ -9,6 +9,7 @@ TCPSocketClient::TCPSocketClient(QTcpSocket* socket, QObject* parent)
 {
     connect(m_socket, &QTcpSocket::readyRead, this, &TCPSocketClient::onReadyRead);
     connect(m_socket, &QTcpSocket::disconnected, this, &TCPSocketClient::onDisconnected);
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &TCPSocketClient::onBytesWritten);
 }
 
 qint64 TCPSocketClient::bytesAvailable()
@@ -46,6 +47,11 @@ bool TCPSocketClient::flush()
     return m_socket->flush();
 }
 
+qint64 TCPSocketClient::bytesToWrite()
+{
+    return m_socket->bytesToWrite();
+}
+
 bool TCPSocketClient::waitForBytesWritten(int msecs)
 {
     return m_socket->waitForBytesWritten(msecs);
@@ -70,3 +76,8 @@ void TCPSocketClient::onReadyRead()
 {
     emit readyRead(this);
 }
+
+void TCPSocketClient::onBytesWritten(qint64 bytes)
+{
+    emit bytesWritten(this, bytes);
+}
@@ -27,27 +27,45 @@ void TCPSocketServer::start()
         return;
     }
 
-    for (int i = 0; i < 10; i++) {
-        if (m_server->listen(QHostAddress::AnyIPv4, m_port + i)) {
-            m_port = m_port + i;
+    // drivers without registry find further instances on the next ports
+    for (int i = 0; i < s_portProbes && m_port != 0; i++)
+    {
+        if (m_server->listen(QHostAddress::AnyIPv4, quint16(m_port + i)))
+        {
             break;
-        } else {
-            qCWarning(categoryTCPSocketServer) << Q_FUNC_INFO << m_server->errorString();
         }
+        qCWarning(categoryTCPSocketServer) << Q_FUNC_INFO << m_port + i << m_server->errorString();
+    }
+
+    // actual port is published by listening()
+    if (!m_server->isListening() && (m_ephemeralFallback || m_port == 0))
+    {
+        m_server->listen(QHostAddress::AnyIPv4, 0);
     }
 
     if (!m_server->isListening())
     {
         qCWarning(categoryTCPSocketServer) << Q_FUNC_INFO << m_server->errorString();
-        qApp->quit();
+        // server lives on transport thread
+        QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
         return;
     }
     else
     {
+        m_port = m_server->serverPort();
         qCWarning(categoryTCPSocketServer) << Q_FUNC_INFO << "listening:" << m_port;
+
+        QVariantMap address;
+        address.insert(QStringLiteral("port"), m_port);
+        emit listening(this, address);
     }
 }
 
+void TCPSocketServer::setEphemeralFallback(bool enabled)
+{
+    m_ephemeralFallback = enabled;
+}
+
 void TCPSocketServer::newConnection()
 {
     auto socket = m_server->nextPendingConnection();
@@ -0,0 +1,266 @@
+#include <qt_qa_engine/QAFrameDecoder.h>
+#include <qt_qa_engine/WebDriverClient.h>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryWebDriverClient, "autoqa.qaengine.transport.webdriver", QtWarningMsg)
+
+namespace
+{
+
+const QString s_w3cElementKey = QStringLiteral("element-6066-11e4-a52e-4f735466cecf");
+
+QByteArray reasonPhrase(int httpStatus)
+{
+    switch (httpStatus)
+    {
+        case 200:
+            return QByteArrayLiteral("OK");
+        case 400:
+            return QByteArrayLiteral("Bad Request");
+        case 404:
+            return QByteArrayLiteral("Not Found");
+        case 405:
+            return QByteArrayLiteral("Method Not Allowed");
+        default:
+            return QByteArrayLiteral("Internal Server Error");
+    }
+}
+
+// engine replies with {"ELEMENT": id}, W3C clients expect the web element key
+QVariant toW3CValue(const QVariant& value)
+{
+    if (value.userType() == QMetaType::QVariantMap)
+    {
+        QVariantMap map = value.toMap();
+        if (map.contains(QStringLiteral("ELEMENT")))
+        {
+            map.insert(s_w3cElementKey, map.value(QStringLiteral("ELEMENT")));
+        }
+        return map;
+    }
+    if (value.userType() == QMetaType::QVariantList)
+    {
+        QVariantList list = value.toList();
+        for (QVariant& item : list)
+        {
+            item = toW3CValue(item);
+        }
+        return list;
+    }
+    return value;
+}
+
+struct W3CError
+{
+    int httpStatus;
+    QString error;
+};
+
+// engine status codes follow JSON Wire Protocol numbering (11 element not visible,
+// 21 timeout), plus HTTP-like 400 and 405
+W3CError toW3CError(int status, const QVariant& value, WebDriverClient::RequestKind kind)
+{
+    switch (status)
+    {
+        case 11:
+            return {400, QStringLiteral("element not interactable")};
+        case 21:
+            return kind == WebDriverClient::ScriptRequest
+                       ? W3CError{500, QStringLiteral("script timeout")}
+                       : W3CError{500, QStringLiteral("timeout")};
+        case 400:
+            return {400, QStringLiteral("invalid argument")};
+        case 405:
+            return {404, QStringLiteral("unknown command")};
+        default:
+            break;
+    }
+
+    // element commands answer an unresolved id with status 1 and "no item" or nothing
+    const QString message = value.toString();
+    if (kind == WebDriverClient::ElementRequest
+        && (message.isEmpty() || message == QLatin1String("no item")))
+    {
+        return {404, QStringLiteral("no such element")};
+    }
+    return {500, QStringLiteral("unknown error")};
+}
+
+} // namespace
+
+WebDriverClient::WebDriverClient(QTcpSocket* socket, QObject* parent)
+    : TCPSocketClient(socket, parent)
+{
+}
+
+void WebDriverClient::append(const QByteArray& data)
+{
+    m_buffer.append(data);
+}
+
+bool WebDriverClient::takeRequest(WebDriverRequest* request)
+{
+    if (m_error)
+    {
+        return false;
+    }
+
+    const int headerEnd = m_buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0)
+    {
+        if (m_buffer.size() > s_maxHeaderSize)
+        {
+            qCWarning(categoryWebDriverClient) << Q_FUNC_INFO << "Header is too big";
+            m_error = true;
+        }
+        return false;
+    }
+
+    const QList<QByteArray> lines = m_buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine.at(2).startsWith("HTTP/1."))
+    {
+        qCWarning(categoryWebDriverClient) << Q_FUNC_INFO << "Malformed request line:" << lines.first();
+        m_error = true;
+        return false;
+    }
+
+    qint64 contentLength = 0;
+    for (int i = 1; i < lines.size(); i++)
+    {
+        const QByteArray& line = lines.at(i);
+        const int colon = line.indexOf(':');
+        if (colon < 0)
+        {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length")
+        {
+            contentLength = value.toLongLong();
+        }
+        else if (name == "transfer-encoding" && value.toLower() != "identity")
+        {
+            qCWarning(categoryWebDriverClient) << Q_FUNC_INFO << "Unsupported transfer encoding:" << value;
+            m_error = true;
+            return false;
+        }
+    }
+
+    if (contentLength < 0 || contentLength > QAFrameDecoder::s_maxFrameSize)
+    {
+        qCWarning(categoryWebDriverClient) << Q_FUNC_INFO << "Bad content length:" << contentLength;
+        m_error = true;
+        return false;
+    }
+
+    const int bodyStart = headerEnd + 4;
+    if (m_buffer.size() - bodyStart < contentLength)
+    {
+        return false;
+    }
+
+    request->method = requestLine.at(0);
+    request->path = requestLine.at(1);
+    request->body = m_buffer.mid(bodyStart, int(contentLength));
+    m_buffer.remove(0, bodyStart + int(contentLength));
+    return true;
+}
+
+bool WebDriverClient::hasError() const
+{
+    return m_error;
+}
+
+qint64 WebDriverClient::nextRequestId()
+{
+    return m_nextRequestId++;
+}
+
+void WebDriverClient::setRequestKind(qint64 requestId, RequestKind kind)
+{
+    if (kind != PlainRequest)
+    {
+        m_requestKinds.insert(requestId, kind);
+    }
+}
+
+void WebDriverClient::sendError(qint64 requestId,
+                                int httpStatus,
+                                const QString& error,
+                                const QString& message)
+{
+    QJsonObject value;
+    value.insert(QStringLiteral("error"), error);
+    value.insert(QStringLiteral("message"), message);
+    value.insert(QStringLiteral("stacktrace"), QString());
+
+    QJsonObject body;
+    body.insert(QStringLiteral("value"), value);
+    queueResponse(requestId, httpStatus, QJsonDocument(body).toJson(QJsonDocument::Compact));
+}
+
+void WebDriverClient::writeReply(const QVariant& requestId, const QVariant& value, int status)
+{
+    if (!requestId.isValid())
+    {
+        qCDebug(categoryWebDriverClient) << Q_FUNC_INFO << "Reply without request:" << value;
+        return;
+    }
+
+    const qint64 id = requestId.toLongLong();
+    const RequestKind kind = m_requestKinds.take(id);
+    if (status != 0)
+    {
+        const W3CError error = toW3CError(status, value, kind);
+        const QString message = value.toString();
+        sendError(id, error.httpStatus, error.error, message.isEmpty() ? error.error : message);
+        return;
+    }
+
+    QVariant result = value;
+    if (kind == FindElementRequest || kind == FindElementsRequest)
+    {
+        // engine replies with empty string when nothing is found
+        const bool multiple = kind == FindElementsRequest;
+        if (result.userType() == QMetaType::QString && result.toString().isEmpty())
+        {
+            if (!multiple)
+            {
+                sendError(id, 404, QStringLiteral("no such element"), QStringLiteral("Element not found"));
+                return;
+            }
+            result = QVariantList();
+        }
+        else if (multiple && result.userType() != QMetaType::QVariantList)
+        {
+            result = QVariantList{result};
+        }
+    }
+
+    QJsonObject body;
+    body.insert(QStringLiteral("value"), QJsonValue::fromVariant(toW3CValue(result)));
+    queueResponse(id, 200, QJsonDocument(body).toJson(QJsonDocument::Compact));
+}
+
+void WebDriverClient::queueResponse(qint64 requestId, int httpStatus, const QByteArray& body)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(httpStatus) + ' ' + reasonPhrase(httpStatus)
+                          + "\r\nContent-Type: application/json; charset=utf-8"
+                          + "\r\nCache-Control: no-cache"
+                          + "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+    response += body;
+
+    m_readyResponses.insert(requestId, response);
+    while (!m_readyResponses.isEmpty() && m_readyResponses.firstKey() == m_nextResponseId)
+    {
+        enqueue(m_readyResponses.take(m_nextResponseId));
+        m_nextResponseId++;
+    }
+}
@@ -0,0 +1,380 @@
+#include <qt_qa_engine/WebDriverClient.h>
+#include <qt_qa_engine/WebDriverServer.h>
+#include <qt_qa_engine/WebDriverSession.h>
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUuid>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryWebDriverServer, "autoqa.qaengine.transport.webdriver", QtWarningMsg)
+
+namespace
+{
+
+// pattern segments starting with ':' match anything and are captured
+bool matchPath(const QStringList& path, const char* pattern, QStringList* captures)
+{
+    const QStringList parts = QString::fromLatin1(pattern).split(QLatin1Char('/'));
+    if (parts.size() != path.size())
+    {
+        return false;
+    }
+
+    QStringList captured;
+    for (int i = 0; i < parts.size(); i++)
+    {
+        if (parts.at(i).startsWith(QLatin1Char(':')))
+        {
+            captured.append(path.at(i));
+        }
+        else if (parts.at(i) != path.at(i))
+        {
+            return false;
+        }
+    }
+    *captures = captured;
+    return true;
+}
+
+} // namespace
+
+WebDriverServer::WebDriverServer(quint16 port, QObject* parent)
+    : ITransportServer(parent)
+    , m_port(port)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &WebDriverServer::newConnection);
+}
+
+void WebDriverServer::start()
+{
+    qCDebug(categoryWebDriverServer) << Q_FUNC_INFO;
+    if (m_server->isListening())
+    {
+        return;
+    }
+
+    if (!m_server->listen(QHostAddress::LocalHost, m_port))
+    {
+        // optional endpoint, main transport keeps working
+        qCWarning(categoryWebDriverServer) << Q_FUNC_INFO << m_server->errorString();
+        return;
+    }
+
+    qCWarning(categoryWebDriverServer) << Q_FUNC_INFO << "listening:" << m_server->serverPort();
+
+    QVariantMap address;
+    address.insert(QStringLiteral("webDriverPort"), m_server->serverPort());
+    emit listening(this, address);
+}
+
+void WebDriverServer::newConnection()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection())
+    {
+        qCDebug(categoryWebDriverServer)
+            << Q_FUNC_INFO << "New connection from:" << socket->peerAddress() << socket->peerPort();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        auto client = new WebDriverClient(socket);
+        registerClient(client);
+    }
+}
+
+void WebDriverServer::readData(ITransportClient* transportClient)
+{
+    auto client = static_cast<WebDriverClient*>(transportClient);
+    client->append(client->readAll());
+
+    WebDriverRequest request;
+    while (client->takeRequest(&request))
+    {
+        handleRequest(client, request);
+    }
+
+    if (client->hasError())
+    {
+        client->sendError(client->nextRequestId(),
+                          400,
+                          QStringLiteral("invalid argument"),
+                          QStringLiteral("Malformed HTTP request"));
+        client->close();
+    }
+}
+
+void WebDriverServer::handleRequest(WebDriverClient* client, const WebDriverRequest& request)
+{
+    qCDebug(categoryWebDriverServer) << Q_FUNC_INFO << request.method << request.path;
+
+    const qint64 requestId = client->nextRequestId();
+
+    QVariantMap body;
+    if (!request.body.trimmed().isEmpty())
+    {
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(request.body, &error);
+        if (error.error != QJsonParseError::NoError || !doc.isObject())
+        {
+            client->sendError(requestId, 400, QStringLiteral("invalid argument"), error.errorString());
+            return;
+        }
+        body = doc.object().toVariantMap();
+    }
+
+    const QString path = QUrl::fromPercentEncoding(request.path.left(request.path.indexOf('?')));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QStringList segments = path.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+#else
+    QStringList segments = path.split(QLatin1Char('/'), QString::SkipEmptyParts);
+#endif
+    // some clients prefix routes with /wd/hub
+    if (segments.size() >= 2 && segments.at(0) == QLatin1String("wd")
+        && segments.at(1) == QLatin1String("hub"))
+    {
+        segments = segments.mid(2);
+    }
+
+    // routes not needing the application are answered here
+    QStringList captures;
+    if (request.method == "GET" && matchPath(segments, "status", &captures))
+    {
+        QVariantMap status;
+        status.insert(QStringLiteral("ready"), true);
+        status.insert(QStringLiteral("message"), QStringLiteral("qaengine"));
+        client->sendReply(requestId, status);
+        return;
+    }
+    if (request.method == "POST" && matchPath(segments, "session", &captures))
+    {
+        const QString sessionId = QUuid::createUuid().toString().mid(1, 36);
+        auto session = new WebDriverSession(sessionId);
+        // replies come from the GUI thread, where commands run
+        session->moveToThread(QCoreApplication::instance()->thread());
+        m_sessions.insert(sessionId, session);
+        emit clientAdded(session);
+
+        QVariantMap reply;
+        reply.insert(QStringLiteral("sessionId"), sessionId);
+        reply.insert(QStringLiteral("capabilities"), body.value(QStringLiteral("capabilities")));
+        client->sendReply(requestId, reply);
+        return;
+    }
+    if (request.method == "DELETE" && matchPath(segments, "session/:sid", &captures))
+    {
+        WebDriverSession* session = m_sessions.take(captures.at(0));
+        if (!session)
+        {
+            client->sendError(requestId, 404, QStringLiteral("invalid session id"), captures.at(0));
+            return;
+        }
+        // posted after commands already queued for the session, so they run before it is gone
+        emit clientLost(session);
+        session->deleteLater();
+        client->sendReply(requestId, QVariant());
+        return;
+    }
+
+    if (segments.size() < 2 || segments.at(0) != QLatin1String("session"))
+    {
+        client->sendError(requestId, 404, QStringLiteral("unknown command"), path);
+        return;
+    }
+
+    WebDriverSession* session = m_sessions.value(segments.at(1));
+    if (!session)
+    {
+        client->sendError(requestId, 404, QStringLiteral("invalid session id"), segments.at(1));
+        return;
+    }
+
+    QACommand command;
+    WebDriverClient::RequestKind kind = WebDriverClient::PlainRequest;
+    if (!route(request.method, segments.mid(2), body, &command.action, &command.params, &kind))
+    {
+        client->sendError(requestId,
+                          404,
+                          QStringLiteral("unknown command"),
+                          QStringLiteral("%1 %2").arg(QString::fromLatin1(request.method), path));
+        return;
+    }
+
+    client->setRequestKind(requestId, kind);
+
+    command.id = session->addRequest(client, requestId);
+    command.received.start();
+    emit commandReceived(session, command);
+}
+
+bool WebDriverServer::route(const QByteArray& method,
+                            const QStringList& path,
+                            const QVariantMap& body,
+                            QString* action,
+                            QVariantList* params,
+                            WebDriverClient::RequestKind* kind)
+{
+    const QString strategy = body.value(QStringLiteral("using")).toString();
+    const QString selector = body.value(QStringLiteral("value")).toString();
+
+    QStringList c;
+    if (method == "POST")
+    {
+        if (matchPath(path, "element", &c) || matchPath(path, "elements", &c))
+        {
+            const bool multiple = path.first() == QLatin1String("elements");
+            *action = multiple ? QStringLiteral("findElements") : QStringLiteral("findElement");
+            *params = {strategy, selector};
+            *kind = multiple ? WebDriverClient::FindElementsRequest
+                             : WebDriverClient::FindElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/element", &c)
+                 || matchPath(path, "element/:eid/elements", &c))
+        {
+            const bool multiple = path.last() == QLatin1String("elements");
+            *action = multiple ? QStringLiteral("findElementsFromElement")
+                               : QStringLiteral("findElementFromElement");
+            *params = {strategy, selector, c.at(0)};
+            *kind = multiple ? WebDriverClient::FindElementsRequest
+                             : WebDriverClient::FindElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/click", &c))
+        {
+            *action = QStringLiteral("click");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/clear", &c))
+        {
+            *action = QStringLiteral("clear");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/value", &c))
+        {
+            QVariantList value = body.value(QStringLiteral("value")).toList();
+            if (value.isEmpty())
+            {
+                for (const QChar& ch : body.value(QStringLiteral("text")).toString())
+                {
+                    value.append(QString(ch));
+                }
+            }
+            *action = QStringLiteral("setValue");
+            *params = {value, c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "actions", &c))
+        {
+            *action = QStringLiteral("performActions");
+            *params = {body.value(QStringLiteral("actions"))};
+        }
+        else if (matchPath(path, "execute/sync", &c) || matchPath(path, "execute/async", &c))
+        {
+            *action = path.last() == QLatin1String("sync") ? QStringLiteral("execute")
+                                                           : QStringLiteral("executeAsync");
+            *params = {body.value(QStringLiteral("script")), body.value(QStringLiteral("args"))};
+            *kind = WebDriverClient::ScriptRequest;
+        }
+        else if (matchPath(path, "back", &c))
+        {
+            *action = QStringLiteral("back");
+        }
+        else if (matchPath(path, "forward", &c))
+        {
+            *action = QStringLiteral("forward");
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else if (method == "GET")
+    {
+        if (matchPath(path, "element/active", &c))
+        {
+            *action = QStringLiteral("active");
+            *kind = WebDriverClient::FindElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/attribute/:name", &c))
+        {
+            *action = QStringLiteral("getAttribute");
+            *params = {c.at(1), c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/property/:name", &c))
+        {
+            *action = QStringLiteral("getProperty");
+            *params = {c.at(1), c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/text", &c))
+        {
+            *action = QStringLiteral("getText");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/rect", &c))
+        {
+            *action = QStringLiteral("getElementRect");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/enabled", &c))
+        {
+            *action = QStringLiteral("elementEnabled");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/displayed", &c))
+        {
+            *action = QStringLiteral("elementDisplayed");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/selected", &c))
+        {
+            *action = QStringLiteral("elementSelected");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "element/:eid/screenshot", &c))
+        {
+            *action = QStringLiteral("getElementScreenshot");
+            *params = {c.at(0)};
+            *kind = WebDriverClient::ElementRequest;
+        }
+        else if (matchPath(path, "screenshot", &c))
+        {
+            *action = QStringLiteral("getScreenshot");
+        }
+        else if (matchPath(path, "source", &c))
+        {
+            *action = QStringLiteral("getPageSource");
+        }
+        else if (matchPath(path, "window/rect", &c))
+        {
+            *action = QStringLiteral("getWindowRect");
+        }
+        else if (matchPath(path, "timeouts", &c))
+        {
+            *action = QStringLiteral("getTimeouts");
+        }
+        else if (matchPath(path, "alert/text", &c))
+        {
+            *action = QStringLiteral("getAlertText");
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#include <qt_qa_engine/WebDriverClient.h>
+#include <qt_qa_engine/WebDriverSession.h>
+
+#include <QMutexLocker>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(categoryWebDriverSession, "autoqa.qaengine.transport.webdriver.session", QtWarningMsg)
+
+WebDriverSession::WebDriverSession(const QString& id, QObject* parent)
+    : ITransportClient(parent)
+    , m_id(id)
+{
+}
+
+QString WebDriverSession::id() const
+{
+    return m_id;
+}
+
+qint64 WebDriverSession::addRequest(WebDriverClient* client, qint64 clientRequestId)
+{
+    Request request;
+    request.client = client;
+    request.requestId = clientRequestId;
+
+    QMutexLocker locker(&m_requestsMutex);
+    const qint64 requestId = m_nextRequestId++;
+    m_requests.insert(requestId, request);
+    return requestId;
+}
+
+qint64 WebDriverSession::bytesAvailable()
+{
+    return 0;
+}
+
+QByteArray WebDriverSession::readAll()
+{
+    return QByteArray();
+}
+
+bool WebDriverSession::isOpen()
+{
+    return true;
+}
+
+bool WebDriverSession::isConnected()
+{
+    return true;
+}
+
+void WebDriverSession::close()
+{
+    // ends with DELETE /session only
+}
+
+qint64 WebDriverSession::write(const QByteArray& data)
+{
+    qCDebug(categoryWebDriverSession) << Q_FUNC_INFO << m_id << "Raw data is not supported, dropping"
+                                      << data.size();
+    return data.size();
+}
+
+bool WebDriverSession::flush()
+{
+    return true;
+}
+
+qint64 WebDriverSession::bytesToWrite()
+{
+    return 0;
+}
+
+bool WebDriverSession::waitForBytesWritten(int)
+{
+    return false;
+}
+
+bool WebDriverSession::waitForReadyRead(int)
+{
+    return false;
+}
+
+void WebDriverSession::writeReply(const QVariant& requestId, const QVariant& value, int status)
+{
+    if (!requestId.isValid())
+    {
+        qCDebug(categoryWebDriverSession) << Q_FUNC_INFO << m_id << "Reply without request:" << value;
+        return;
+    }
+
+    QMutexLocker locker(&m_requestsMutex);
+    const Request request = m_requests.take(requestId.toLongLong());
+    locker.unlock();
+
+    if (!request.client)
+    {
+        qCDebug(categoryWebDriverSession)
+            << Q_FUNC_INFO << m_id << "Connection of request" << requestId << "is gone";
+        return;
+    }
+    request.client->sendReply(request.requestId, value, status);
+}
@@ -37,6 +37,9 @@ namespace
 QList<QAction*> s_actions;
 QHash<QAction*, QSet<QWidget*> > s_actionHash;
 QHash<QMenu*, QWidget*> s_menuHash;
+// reverse of the hashes above, removal of a destroyed object is a few lookups
+QHash<QWidget*, QSet<QAction*> > s_widgetActions;
+QHash<QWidget*, QSet<QMenu*> > s_widgetMenus;
 EventHandler* s_eventHandler = nullptr;
 
 static bool s_registerPlatform = []()
@@ -54,6 +57,44 @@ static bool s_registerPlatform = []()
     return true;
 }();
 
+void rememberActionWidget(QAction* action, QWidget* widget)
+{
+    s_actionHash[action].insert(widget);
+    s_widgetActions[widget].insert(action);
+}
+
+void forgetActionWidget(QAction* action, QWidget* widget)
+{
+    auto actions = s_widgetActions.find(widget);
+    if (actions != s_widgetActions.end())
+    {
+        actions->remove(action);
+        if (actions->isEmpty())
+        {
+            s_widgetActions.erase(actions);
+        }
+    }
+}
+
+void rememberMenuOwner(QMenu* menu, QWidget* widget)
+{
+    s_menuHash.insert(menu, widget);
+    s_widgetMenus[widget].insert(menu);
+}
+
+void forgetMenuOwner(QMenu* menu, QWidget* widget)
+{
+    auto menus = s_widgetMenus.find(widget);
+    if (menus != s_widgetMenus.end())
+    {
+        menus->remove(menu);
+        if (menus->isEmpty())
+        {
+            s_widgetMenus.erase(menus);
+        }
+    }
+}
+
 } // namespace
 
 QList<QObject*> WidgetsEnginePlatform::childrenList(QObject* parentItem)
@@ -62,6 +103,8 @@ QList<QObject*> WidgetsEnginePlatform::childrenList(QObject* parentItem)
     {
         s_actionHash.clear();
         s_menuHash.clear();
+        s_widgetActions.clear();
+        s_widgetMenus.clear();
     }
 
     QList<QObject*> result;
@@ -76,7 +119,7 @@ QList<QObject*> WidgetsEnginePlatform::childrenList(QObject* parentItem)
     {
         for (QAction* action : widget->actions())
         {
-            s_actionHash[action].insert(widget);
+            rememberActionWidget(action, widget);
             if (action->menu() && action->menu() != widget)
             {
                 if (s_menuHash.contains(action->menu()))
@@ -88,7 +131,7 @@ QList<QObject*> WidgetsEnginePlatform::childrenList(QObject* parentItem)
                 }
                 else
                 {
-                    s_menuHash.insert(action->menu(), widget);
+                    rememberMenuOwner(action->menu(), widget);
                 }
                 if (action->menu()->isActiveWindow()) {
                     result.append(action->menu());
@@ -138,7 +181,7 @@ QList<QObject*> WidgetsEnginePlatform::childrenList(QObject* parentItem)
                 }
                 else
                 {
-                    s_menuHash.insert(m, w);
+                    rememberMenuOwner(m, w);
                 }
                 if (!m->isActiveWindow()) {
                     continue;
@@ -184,39 +227,50 @@ void WidgetsEnginePlatform::removeItem(QObject* o)
 {
     GenericEnginePlatform::removeItem(o);
 
+    // o may be partially destroyed, it is only used as a key
+    QAction* action = reinterpret_cast<QAction*>(o);
+    QWidget* widget = reinterpret_cast<QWidget*>(o);
+    QMenu* menu = reinterpret_cast<QMenu*>(o);
+
+    auto actionWidgets = s_actionHash.find(action);
+    if (actionWidgets != s_actionHash.end())
     {
-        QHash<QAction*, QSet<QWidget*> >::iterator i = s_actionHash.begin();
-        while (i != s_actionHash.end())
+        for (QWidget* w : actionWidgets.value())
         {
-            if (i.value().contains(reinterpret_cast<QWidget*>(o))) {
-                i.value().remove(reinterpret_cast<QWidget*>(o));
-            }
-            if (i.key() == o)
-            {
-                i = s_actionHash.erase(i);
-                break;
-            }
-            else
-            {
-                ++i;
-            }
+            forgetActionWidget(action, w);
         }
+        s_actionHash.erase(actionWidgets);
     }
 
+    auto widgetActions = s_widgetActions.find(widget);
+    if (widgetActions != s_widgetActions.end())
     {
-        QHash<QMenu*, QWidget*>::iterator i = s_menuHash.begin();
-        while (i != s_menuHash.end())
+        for (QAction* a : widgetActions.value())
         {
-            if (i.value() == o || i.key() == o)
-            {
-                i = s_menuHash.erase(i);
-                break;
-            }
-            else
+            auto widgets = s_actionHash.find(a);
+            if (widgets != s_actionHash.end())
             {
-                ++i;
+                widgets->remove(widget);
             }
         }
+        s_widgetActions.erase(widgetActions);
+    }
+
+    auto menuOwner = s_menuHash.find(menu);
+    if (menuOwner != s_menuHash.end())
+    {
+        forgetMenuOwner(menu, menuOwner.value());
+        s_menuHash.erase(menuOwner);
+    }
+
+    auto ownedMenus = s_widgetMenus.find(widget);
+    if (ownedMenus != s_widgetMenus.end())
+    {
+        for (QMenu* m : ownedMenus.value())
+        {
+            s_menuHash.remove(m);
+        }
+        s_widgetMenus.erase(ownedMenus);
     }
 }
 
@@ -381,10 +435,10 @@ void WidgetsEnginePlatform::executeCommand_app_clickInView(ITransportClient* soc
 
     const QPoint itemPos = getAbsPosition(item);
     const QPoint indexCenter(rect.center().x() + itemPos.x(), rect.center().y() + itemPos.y());
-    clickPoint(indexCenter);
-
-    socketReply(socket,
-                QStringList({QString::number(indexCenter.x()), QString::number(indexCenter.y())}));
+    QAPendingEvent* pending = clickPoint(indexCenter);
+    pending->setResult(
+        QStringList({QString::number(indexCenter.x()), QString::number(indexCenter.y())}));
+    pendingReply(socket, pending);
 }
 
 void WidgetsEnginePlatform::executeCommand_app_scrollInView(ITransportClient* socket,
@@ -978,26 +1032,21 @@ void WidgetsEnginePlatform::grabScreenshot(ITransportClient* socket,
         pix.save(&buffer, "PNG");
     }
 
-    socketReply(socket, arr.toBase64());
+    socketReply(socket, socket->payloadValue(arr));
 }
 
-void WidgetsEnginePlatform::pressAndHoldItem(QObject* qitem, int delay)
+QAPendingEvent* WidgetsEnginePlatform::pressAndHoldItem(QObject* qitem, int delay)
 {
     qCDebug(categoryWidgetsEnginePlatform) << Q_FUNC_INFO << qitem << delay;
 
-    if (!qitem)
-    {
-        return;
-    }
-
     QWidget* item = qobject_cast<QWidget*>(qitem);
     if (!item)
     {
-        return;
+        return completedEvent(QVariant());
     }
 
     const QPoint itemCenter = getAbsGeometry(item).center();
-    pressAndHold(itemCenter.x(), itemCenter.y(), delay);
+    return pressAndHold(itemCenter.x(), itemCenter.y(), delay);
 }
 
 EventHandler::EventHandler(QObject* parent)
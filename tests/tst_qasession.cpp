@@ -0,0 +1,181 @@
+#include <qt_qa_engine/ITransportClient.h>
+#include <qt_qa_engine/QACommand.h>
+#include <qt_qa_engine/QASession.h>
+
+#include <QtTest>
+
+namespace
+{
+
+class FakeClient : public ITransportClient
+{
+    Q_OBJECT
+public:
+    qint64 bytesAvailable() override
+    {
+        return 0;
+    }
+    QByteArray readAll() override
+    {
+        return QByteArray();
+    }
+
+    bool isOpen() override
+    {
+        return true;
+    }
+    bool isConnected() override
+    {
+        return true;
+    }
+    void close() override
+    {
+    }
+
+    qint64 write(const QByteArray& data) override
+    {
+        written.append(data);
+        return data.size();
+    }
+    bool flush() override
+    {
+        return true;
+    }
+    qint64 bytesToWrite() override
+    {
+        return 0;
+    }
+
+    bool waitForBytesWritten(int) override
+    {
+        return true;
+    }
+    bool waitForReadyRead(int) override
+    {
+        return false;
+    }
+
+    QByteArray written;
+};
+
+QACommand anonymousCommand(const QString& action)
+{
+    QACommand command;
+    command.action = action;
+    command.received.start();
+    return command;
+}
+
+} // namespace
+
+class TestQASession : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pipelinedAnonymousCommands();
+    void commandsWithIdBypassQueue();
+    void dispatchWithoutReplyReleasesSlot();
+    void deferredReplyKeepsSlot();
+};
+
+void TestQASession::pipelinedAnonymousCommands()
+{
+    FakeClient client;
+    QASession* session = QASession::forClient(&client);
+
+    QList<QACommand> ready;
+    connect(session,
+            &QASession::commandReady,
+            this,
+            [&ready](ITransportClient*, const QACommand& command) { ready.append(command); });
+
+    QVERIFY(session->admitCommand(anonymousCommand(QStringLiteral("first"))));
+    QVERIFY(!session->admitCommand(anonymousCommand(QStringLiteral("second"))));
+    QVERIFY(ready.isEmpty());
+
+    // reply to the first one hands the slot to the second one
+    client.sendReply(QVariant(), QString());
+    QCOMPARE(ready.size(), 1);
+    QCOMPARE(ready.first().action, QStringLiteral("second"));
+
+    // re-dispatched command must run instead of going back to the backlog
+    QVERIFY(session->admitCommand(ready.first()));
+
+    client.sendReply(QVariant(), QString());
+    QCOMPARE(ready.size(), 1);
+
+    // slot is free again
+    QVERIFY(session->admitCommand(anonymousCommand(QStringLiteral("third"))));
+
+    QASession::close(&client);
+}
+
+void TestQASession::commandsWithIdBypassQueue()
+{
+    FakeClient client;
+    QASession* session = QASession::forClient(&client);
+
+    QVERIFY(session->admitCommand(anonymousCommand(QStringLiteral("first"))));
+
+    QACommand withId = anonymousCommand(QStringLiteral("second"));
+    withId.id = 42;
+    QVERIFY(session->admitCommand(withId));
+
+    // reply with id does not free the slot of the command without id
+    client.sendReply(42, QString());
+    QVERIFY(!session->admitCommand(anonymousCommand(QStringLiteral("third"))));
+
+    QASession::close(&client);
+}
+
+void TestQASession::dispatchWithoutReplyReleasesSlot()
+{
+    FakeClient client;
+    QASession* session = QASession::forClient(&client);
+
+    QList<QACommand> ready;
+    connect(session,
+            &QASession::commandReady,
+            this,
+            [&ready](ITransportClient*, const QACommand& command) { ready.append(command); });
+
+    const QACommand first = anonymousCommand(QStringLiteral("initialize"));
+    QVERIFY(session->admitCommand(first));
+    QVERIFY(!session->admitCommand(anonymousCommand(QStringLiteral("second"))));
+
+    // handler returned without replying, nothing goes out on the wire
+    session->beginDispatch(first);
+    session->endDispatch();
+    QVERIFY(client.written.isEmpty());
+    QCOMPARE(ready.size(), 1);
+    QCOMPARE(ready.first().action, QStringLiteral("second"));
+
+    // replying handler releases the slot once
+    session->beginDispatch(ready.first());
+    client.sendReply(QVariant(), QString());
+    session->endDispatch();
+    QVERIFY(session->admitCommand(anonymousCommand(QStringLiteral("third"))));
+
+    QASession::close(&client);
+}
+
+void TestQASession::deferredReplyKeepsSlot()
+{
+    FakeClient client;
+    QASession* session = QASession::forClient(&client);
+
+    const QACommand first = anonymousCommand(QStringLiteral("getScreenshot"));
+    QVERIFY(session->admitCommand(first));
+
+    session->beginDispatch(first);
+    session->deferReply();
+    session->endDispatch();
+    QVERIFY(!session->admitCommand(anonymousCommand(QStringLiteral("second"))));
+
+    QASession::close(&client);
+}
+
+QTEST_GUILESS_MAIN(TestQASession)
+
+#include "tst_qasession.moc"